@@ -69,6 +69,10 @@
 	MEN F14 (Pentium CPCI) F205 (CPCI Carrier)	   Standard or _a24
 	\endcode
 
+    The SDRAM data need no byte swapping in the swapped variants, these
+    access a memory mapped module directly. The non-swapped variants
+    transfer the raw bus data and swap the buffer afterwards in one pass.
+
     \n \section FuncDesc Functional Description
 
     \n \subsection reading Reading and Writing Data
@@ -76,8 +80,220 @@
 	the Getstat and Setstat code M199_BLK_SDRAM.
 	The Universal Submodule can be read or written with the Getstat and
 	Setstat code M199_BLK_USM_MODULE.
+	The Setstat code M199_BLK_USM_UPDATE reads the EEPROM first and writes
+	only the words that differ. Both write codes poll the EEPROM for the end
+	of each write cycle. The Getstat code M199_USM_WR_COUNT returns the number
+	of words written by the last write.
+	Single words can be read with the Getstat code M199_BLK_USM_PART, that
+	takes the first word and the number of words (M199_USM_PART).
+	If the descriptor key USM_CACHE is set (or the Setstat code M199_USM_CACHE
+	is set to 1), the driver keeps a shadow of the EEPROM that is filled on
+	first access and updated by the write codes. Reads are then served from
+	memory. Setting M199_USM_CACHE again discards the shadow.
 	The driver supports reading the fpga header at the flash with the Getstat
-	code M199_BLK_FPGA_HEADER.
+	code M199_BLK_FPGA_HEADER. The header is read once at M199_Init() and
+	returned from memory. The Getstat code M199_BLK_FPGA_INFO returns the
+	decoded header (M199_FPGA_INFO) with the file name of the FPGA
+	configuration.
+	Any range of the flash can be read with the Getstat code M199_BLK_FLASH
+	(M199_FLASH_ACCESS). The driver returns the 32-bit sum of all read words;
+	with the flag M199_FLASH_SUM_ONLY only the sum is returned, e.g. to verify
+	a complete FPGA configuration in one call. The flash size is defined by
+	the descriptor key FLASH_SIZE.
+
+	Larger SDRAM areas can be streamed with M_getblock() and M_setblock().
+	The transfer starts at the block i/o position that is set and read with
+	the Setstat/Getstat code M199_SDRAM_POS and is advanced by the number of
+	transferred bytes. In A08 mode the SDRAM address register is programmed
+	only once per block, independent of the block size.
+	The A24 variants access the SDRAM with D32 cycles. An unaligned first or
+	last word is transferred with a D16 cycle. The carrier board must support
+	D32 accesses in this case.
+
+	Several non-contiguous SDRAM areas can be read or written in one call with
+	the Getstat/Setstat code M199_BLK_SDRAM_SG. The block contains a
+	M199_SDRAM_SG segment list followed by the data of all segments. In A08
+	mode the SDRAM address register is only programmed for segments that do
+	not continue the previous segment.
+
+	With the Setstat code M199_SDRAM_VERIFY the driver reads back all SDRAM
+	data written on the channel (M199_BLK_SDRAM, M199_BLK_SDRAM_SG and
+	M_setblock()) and compares it in the same call. A write with
+	mismatching words fails with ERR_LL_WRITE, the Getstat code
+	M199_BLK_VERIFY_STAT returns the number of mismatching words and the
+	offset of the first one (M199_VERIFY_STAT) of the last verified write.
+
+	\n \subsection channels SDRAM Channels
+	The SDRAM can be divided into up to 16 channels (descriptor key
+	SDRAM_CH_NUM), e.g. for a capture writer and an analysis reader. By
+	default the channels are equal parts of the SDRAM, otherwise the area of
+	channel n is defined by the keys CHANNEL_n/SDRAM_BASE and
+	CHANNEL_n/SDRAM_SIZE. The areas must not overlap. The channel of a path
+	is selected with M_setstat(M_MK_CH_CURRENT). All SDRAM offsets
+	(M199_BLK_SDRAM, M199_BLK_SDRAM_SG, M199_SDRAM_POS) are relative to the
+	channel's area and accesses beyond it are rejected with ERR_LL_ILL_PARAM,
+	M_getblock() and M_setblock() are truncated at its end. Each channel has
+	its own block i/o position. M199_BLK_SDRAM_MAP returns the window of the
+	channel's area.
+
+	\n \subsection locking Locking
+	The driver uses the MDIS lock mode LL_LOCK_NONE and locks internally
+	only what must not be interrupted:
+	- the block i/o position and the transfers of each channel
+	- the A08 SDRAM address/data port (not used by the A24 variants)
+	- the flash address/data port
+	- the USM EEPROM, its shadow and the ID PROM
+	- the interrupt and signal configuration
+
+	Calls that access a single register (M199_LED) or return counters or
+	cached data (e.g. M199_BLK_FPGA_HEADER, M199_BLK_IRQ_COUNT) are not
+	locked and are not delayed by SDRAM or flash transfers. In the A24
+	variants SDRAM transfers of different channels run in parallel.
+
+	\n \subsection flash_prog FPGA Flash Programming
+	The FPGA configuration can be updated with the Setstat code
+	M199_BLK_FLASH_PROG (M199_FLASH_PROG). The data start at a sector
+	boundary (descriptor key FLASH_SECT_SIZE) and may span several sectors,
+	so a configuration can be streamed in blocks of one or more sectors.
+	Each sector is compared with the new data first and skipped if it is
+	unchanged, otherwise it is erased, programmed and read back for
+	verification. The Getstat code M199_BLK_FLASH_STAT returns the progress
+	counters (M199_FLASH_STAT), that are reset by a block with the flag
+	M199_FLASH_PROG_FIRST. It is not locked, so another path can poll the
+	progress while M199_BLK_FLASH_PROG is running; the counters of one call
+	may then differ by the sector in progress. The driver uses the Intel
+	flash command set.
+
+	\n \subsection stats Statistics
+	The driver counts its register accesses (D16/D32 read and write cycles,
+	writes of the SDRAM and flash address registers), the bytes transferred
+	to and from the SDRAM, the flash and the USM EEPROM, and the calls and
+	OSS ticks spent in M_getblock(), M_setblock() and in each Getstat and
+	Setstat code. The Getstat code M199_BLK_STATS returns these counters in
+	a M199_STATS structure, M199_STAT_SLOT() converts a status code into
+	the index of the per-code arrays. The counters wrap around at 2^32 and
+	are reset with the Setstat code M199_STATS_RESET. They are not locked,
+	so they are approximate: concurrent calls on other channels, unlocked
+	codes and the interrupt handler may lose single counts. They cost no bus
+	cycles and can be used to compare transfer strategies, e.g. the number
+	of SDRAM address register writes of a M199_BLK_SDRAM_SG list.
+
+	\n \subsection sdram_test SDRAM Memory Test
+	The Getstat code M199_BLK_SDRAM_TEST runs memory tests over an area of
+	the channel's SDRAM inside the driver: walking ones and zeros,
+	address-in-address, checkerboard and a pseudo-random pattern with a
+	given seed. Only the failure report is returned in the M199_SDRAM_TEST
+	structure: the number of failing words, the tests that failed and the
+	first M199_SDRAM_ERR_NUM failures with offset, expected and actual
+	value. The test stops after maxErr failures (0: no limit). The area is
+	overwritten and its previous contents are lost.
+
+	\n \subsection sdram_fill SDRAM Fill and Copy
+	An area of the channel's SDRAM can be filled with a 16-bit or 32-bit
+	pattern (Setstat code M199_BLK_SDRAM_FILL, M199_SDRAM_FILL) and copied
+	to another area of the channel (M199_BLK_SDRAM_COPY, M199_SDRAM_COPY)
+	without transferring the data through the application. The copy areas
+	may overlap. In A08 mode the data goes through the autoincrementing
+	SDRAM port, in blocks that release the port in between, the copy uses
+	a small driver buffer. In A24 mode the window is accessed directly with
+	D32 cycles, a copy between areas of different D32 alignment uses D16
+	cycles.
+
+	\n \subsection sdram_check SDRAM Checksum and Search
+	The Getstat code M199_BLK_SDRAM_CHECK returns the 64-bit sum, the
+	smallest and the largest of the 16-bit words of an area of the channel's
+	SDRAM and optionally their CRC-32 (M199_SDRAM_CHECK). The words are
+	unsigned or, with M199_SDRAM_CHECK_SIGNED, int16 samples. The lower 32
+	bits of the unsigned sum are the same additive checksum as returned by
+	M199_BLK_FLASH. M199_BLK_SDRAM_FIND returns the offset of the first
+	word of an area that matches a value under a mask (M199_SDRAM_FIND).
+	The driver reads the area in blocks into a small buffer, only the
+	results are copied to the application.
+
+	\n \subsection sdram_async Asynchronous SDRAM Transfers
+	The Setstat code M199_BLK_ASYNC_SUBMIT queues a read or write of an area
+	of the channel's SDRAM (M199_ASYNC_REQ) and returns at once, the data of
+	a write are copied into the driver. Up to 32 transfers of all channels
+	and paths may be queued. The transfers are executed in submit order by
+	an OSS timer callback of the driver. It locks the channel for 2 KB at a
+	time and ends its run after about 2 ms, restarting the timer for the
+	rest, so the timer context never holds the CPU for long. If the channel
+	or the SDRAM port is in use by a synchronous call, the callback retries
+	one timer period (at least 1 ms) later. If the channel verifies writes
+	(M199_SDRAM_VERIFY) when a write is submitted, each 2 KB part is read
+	back; a mismatch fails the transfer with
+	ERR_LL_WRITE and sets the channel's M199_BLK_VERIFY_STAT result.
+
+	The Getstat code M199_BLK_ASYNC_WAIT waits for the transfer with a given
+	tag or, with M199_ASYNC_ANY, for the oldest transfer of the channel,
+	removes it and returns its result and the data of a read
+	(M199_ASYNC_DONE). A transfer can be waited for by one caller only.
+	With the Setstat code M199_ASYNC_SIG_SET the driver also sends a signal
+	on each completed transfer, M199_ASYNC_SIG_CLR removes it.
+
+	Completed transfers stay queued until they are waited for. If the queue
+	is full, a submit drops the oldest completed transfer that nobody waits
+	for, a later wait for its tag fails with ERR_LL_ILL_PARAM. If all queued
+	transfers are in progress or waited for, the submit fails with
+	ERR_LL_DEV_BUSY. Transfers that were not waited for are discarded when
+	the device is closed.
+
+	\n \subsection user_reg User Module Registers
+	The registers of the FPGA user module (offset 0x00..0xCF) are read and
+	written with the Getstat/Setstat code M199_BLK_USER_REG
+	(M199_USER_REG). A call transfers a range of consecutive D16 or D32
+	registers, each value in a u_int32. D32 registers are accessed low word
+	first, like the interrupt registers. Ranges beyond the user module are
+	rejected with ERR_LL_ILL_PARAM. In the A24 variants these offsets
+	address the SDRAM window, so the user module is not accessible.
+
+	The Getstat code M199_BLK_REG_WAIT polls a user module register in the
+	driver until (register & mask) == value or the timeout expires
+	(M199_REG_WAIT). Between the polls the driver delays busy for the given
+	interval, or sleeps with M199_REG_WAIT_SLEEP, which is required for an
+	endless wait. A busy wait is limited to a timeout and an interval of
+	M199_REG_WAIT_BUSY_MAX (100 ms, i.e. an interval of 100000 us), longer
+	waits must sleep. The last register value, the wait time and the
+	number of polls are returned, also on a timeout.
+
+	M_read() and M_write() read and write one user module register of the
+	current channel, defined by the descriptor keys CHANNEL_n/USER_REG and
+	CHANNEL_n/USER_WIDTH (the number of channels is SDRAM_CH_NUM). These
+	calls are not locked and are the fastest way to access a single
+	register, e.g. a set-point. On a channel without a register they fail
+	with ERR_LL_ILL_CHAN.
+
+	\n \subsection cmd_list Command Lists
+	The Getstat code M199_BLK_CMD_LIST executes a list of commands in one
+	call (M199_CMD_LIST): D16/D32 reads and writes of user module registers,
+	LED and interrupt enable settings, SDRAM writes and reads of the
+	channel's area and delays. The data of the SDRAM commands follow the
+	list in its order. The whole list is checked before the first command
+	is executed, an illegal command fails the call with ERR_LL_ILL_PARAM,
+	SDRAM data exceeding the block with ERR_LL_USERBUF. A delay busy-waits
+	with the locks held and is limited to M199_CMD_DELAY_MAX (10 ms).
+	The commands are executed while the channel and the interrupt
+	configuration are locked. The list stops at the first failing command,
+	e.g. a verified SDRAM write (M199_SDRAM_VERIFY); each command returns
+	its result and read value, the list the number of successful commands.
+	The user module registers are not decoded in the A24 variants.
+
+	\n \subsection sdram_map SDRAM Window Mapping
+	In the A24 variants the whole SDRAM is directly addressable in the
+	module's address space. The Getstat code M199_BLK_SDRAM_MAP returns a
+	M199_SDRAM_MAP structure with the physical address, the offset and the
+	size of the channel's area in this window. The physical address of the
+	window is not known to the driver and must be set with the descriptor
+	key SDRAM_PHYS_ADDR (e.g. the A24 address of the M-Module slot as seen
+	by the CPU), otherwise the Getstat code fails with ERR_LL_ILL_FUNC.
+	The driver does not map the window itself. The application maps the
+	area with the means of its operating system (e.g. mmap() of /dev/mem
+	on Linux, rounded to pages) and must unmap it before the device is
+	closed.
+	Note that the register block 0xD0..0xFF overlays the window, so the
+	first channel should not start below 0x100.
+	Note that the window provides the raw bus byte order, without the byte
+	swapping of M199_BLK_SDRAM in the non-swapped variants.
 
 	\n \subsection led LED switching
     The driver can set or clear the onboard LEDs. The seven light emitting
@@ -86,10 +302,28 @@
     can be received through the GetStat M199_LED code.
 
     \n \section interrupts Interrupts
-    The driver does not support interrupts from the M-Module.
+    The FPGA user cores can request interrupts through the 32 sources of the
+    interrupt request register (IRR). The sources that are enabled with
+    M_MK_IRQ_ENABLE are defined by the descriptor key IRQ_MASK and can be
+    changed with the Setstat code M199_IRQ_MASK.
+
+    The interrupt routine acknowledges the pending sources by writing them
+    back to the IRR, counts the interrupts per source and queues an event
+    with the sources and the OSS tick count. Up to 64 events are queued,
+    further events are counted as lost.
+
+    The Getstat code M199_BLK_IRQ_WAIT returns the oldest queued event and
+    waits up to the specified time if the queue is empty. The device is not
+    locked while waiting. The Getstat code M199_BLK_IRQ_COUNT returns the
+    interrupt count of each source. The Setstat code M199_IRQ_CLR clears the
+    event queue and all interrupt counters.
+
+    Note that the module has no knowledge of MDIS paths, so all paths of a
+    device share one event queue.
 
     \n \section signals Signals
-    The driver does not support signals.
+    The driver can send a signal on each interrupt. The signal is installed
+    with the Setstat code M199_SIG_SET and removed with M199_SIG_CLR.
     \n
 
     \n \section id_prom ID PROM
@@ -144,6 +378,62 @@
         <td>LED = U_INT32 127</td>
         <td>0..127, default: 127</td>
     </tr>
+    <tr>
+    	<td>IRQ_MASK</td>
+        <td>IRQ_MASK = U_INT32 0xffffffff</td>
+        <td>interrupt sources enabled by M_MK_IRQ_ENABLE,
+        	default: 0xffffffff</td>
+    </tr>
+    <tr>
+    	<td>USM_CACHE</td>
+        <td>USM_CACHE = U_INT32 0</td>
+        <td>0..1 (USM EEPROM shadow), default: 0</td>
+    </tr>
+    <tr>
+    	<td>FLASH_SIZE</td>
+        <td>FLASH_SIZE = U_INT32 0x1000000</td>
+        <td>flash size in bytes, default: 0x1000000</td>
+    </tr>
+    <tr>
+    	<td>FLASH_SECT_SIZE</td>
+        <td>FLASH_SECT_SIZE = U_INT32 0x20000</td>
+        <td>flash sector size in bytes, default: 0x20000</td>
+    </tr>
+    <tr>
+    	<td>SDRAM_CH_NUM</td>
+        <td>SDRAM_CH_NUM = U_INT32 1</td>
+        <td>number of SDRAM channels 1..16, default: 1</td>
+    </tr>
+    <tr>
+    	<td>CHANNEL_n/SDRAM_BASE</td>
+        <td>SDRAM_BASE = U_INT32 0x0</td>
+        <td>SDRAM base of channel n in bytes,
+        	default: n * (0x1000000 / SDRAM_CH_NUM)</td>
+    </tr>
+    <tr>
+    	<td>CHANNEL_n/SDRAM_SIZE</td>
+        <td>SDRAM_SIZE = U_INT32 0x1000000</td>
+        <td>SDRAM size of channel n in bytes,
+        	default: 0x1000000 / SDRAM_CH_NUM</td>
+    </tr>
+    <tr>
+    	<td>CHANNEL_n/USER_REG</td>
+        <td>USER_REG = U_INT32 0x0</td>
+        <td>user module register of channel n for M_read()/M_write(),
+        	0x00..0xCF (A08 only), default: none</td>
+    </tr>
+    <tr>
+    	<td>CHANNEL_n/USER_WIDTH</td>
+        <td>USER_WIDTH = U_INT32 2</td>
+        <td>width of the user register of channel n in bytes,
+        	2 (D16) or 4 (D32), default: 2</td>
+    </tr>
+    <tr>
+    	<td>SDRAM_PHYS_ADDR</td>
+        <td>SDRAM_PHYS_ADDR = U_INT32 0x0</td>
+        <td>physical address of the SDRAM window for M199_BLK_SDRAM_MAP
+        	(A24 only), default: 0 (unknown)</td>
+    </tr>
     </table>
 
     \n \section codes M199 specific Getstat/Setstat codes
@@ -153,6 +443,25 @@
 
     \subsection m199_simp  Simple example for using the driver
     m199_simp.c (see example section)
+
+    \subsection m199_sim  Register-level simulator
+    m199_sim (TOOLS/M199_SIM) runs the unmodified driver in user space
+    against a model of the M199 registers (ID PROM, LED, SDRAM port and
+    A24 window, flash, USM EEPROM, IRR/IER). The driver is compiled with
+    the switch M199_SIM, which replaces maccess.h by m199_sim.h. The program
+    transfers data through the driver, checks it against the model and
+    prints the D16/D32 read and write cycles of each operation. Its exit
+    code is the number of failed operations. program.mak builds the A08
+    variant, program_a24.mak the A24 variant.
+
+    \subsection m199_api  Client library
+    m199_api (LIBSRC/M199_API) wraps the block Getstat/Setstat codes into
+    typed calls on a device handle (see m199_api.h). M199API_Open() allocates
+    a pool of transfer buffers which is reused by all transfers. SDRAM,
+    flash and register transfers of any size are split into blocks of the
+    buffer size. A buffer of the pool got by M199API_BufGet() is transferred
+    in place. For C++, m199::Device and m199::Buffer close the device and
+    return the buffer on destruction.
 */
 
 /** \example m199_simp.c */
@@ -8,7 +8,8 @@
  *
  *     Required: OSS, DESC, DBG, ID libraries
  *
- *     \switches _ONE_NAMESPACE_PER_DRIVER_
+ *     \switches _ONE_NAMESPACE_PER_DRIVER_, M199_A24, MAC_BYTESWAP,
+ *               M199_SIM (run against the register model in m199_sim.h)
  *
  *
  *---------------------------------------------------------------------------
@@ -33,7 +34,11 @@
 #define _NO_LL_HANDLE		/* ll_defs.h: don't define LL_HANDLE struct */
 
 #include <MEN/men_typs.h>   /* system dependent definitions   */
-#include <MEN/maccess.h>    /* hw access macros and types     */
+#ifdef M199_SIM
+# include <MEN/m199_sim.h>  /* simulated hw access (M199_SIM) */
+#else
+# include <MEN/maccess.h>   /* hw access macros and types     */
+#endif
 #include <MEN/dbg.h>        /* debug functions                */
 #include <MEN/oss.h>        /* oss functions                  */
 #include <MEN/desc.h>       /* descriptor functions           */
@@ -47,12 +52,34 @@
 |  DEFINES                                 |
 +-----------------------------------------*/
 /* general defines */
-#define CH_NUMBER			1			/**< Number of device channels */
-#define USE_IRQ				FALSE		/**< Interrupt required  */
+#define USE_IRQ				TRUE		/**< Interrupt required  */
 #define ADDRSPACE_COUNT		1			/**< Number of required address spaces */
 #define ADDRSPACEA08_SIZE	256			/**< Size of A08 address space */
 #define ADDRSPACEA24_SIZE	0x1000000	/**< Size of A24 address space */
 
+#define IRQ_EVQ_SIZE		64			/**< Size of interrupt event queue */
+
+#define SDRAM_BUF_WORDS		1024		/**< SDRAM test/copy block [words] */
+#define ASYNC_CHUNK			SDRAM_BUF_WORDS	/**< Async words per lock */
+#define ASYNC_DELAY			1			/**< Async worker start delay [ms] */
+#define ASYNC_RETRY			1			/**< Async worker retry delay [ms] */
+#define ASYNC_RUN_MAX		2			/**< Async worker run time [ms] */
+#define FLASH_ADDR_UNKNOWN	0xFFFFFFFF	/**< Flash address register unknown */
+#define FLASH_ERASE_TIMEOUT	5000		/**< Flash sector erase timeout [ms] */
+#define FLASH_PROG_TIMEOUT	10			/**< Flash word program timeout [ms] */
+
+/* flash commands and status bits (Intel command set) */
+#define FLASH_CMD_READ		0xFF		/**< Read array */
+#define FLASH_CMD_STATUS	0x70		/**< Read status register */
+#define FLASH_CMD_CLRSTAT	0x50		/**< Clear status register */
+#define FLASH_CMD_PROG		0x40		/**< Word program */
+#define FLASH_CMD_ERASE		0x20		/**< Block erase */
+#define FLASH_CMD_LOCK		0x60		/**< Lock bit setup */
+#define FLASH_CMD_CONFIRM	0xD0		/**< Erase confirm / unlock */
+#define FLASH_SR_READY		0x80		/**< Status: write state machine ready */
+#define FLASH_SR_ERROR		0x3A		/**< Status: erase/program/Vpp/lock err */
+#define USM_WR_TIMEOUT		20			/**< USM EEPROM write timeout [ms] */
+
 #define MOD_ID_MAGIC		0x5346   	/**< ID PROM magic word */
 #define MOD_ID_SIZE			128			/**< ID PROM size [bytes] */
 #define MOD_ID				199			/**< ID PROM module ID */
@@ -73,22 +100,107 @@
 #define DBG_MYLEVEL			llHdl->dbgLevel   /**< Debug level */
 #define DBH					llHdl->dbgHdl     /**< Debug handle */
 
-#define M199_MWRITE_D16(addr,offs,val)  (MWRITE_D16(addr,offs,OSS_SWAP16((val))))
-#define M199_MREAD_D16(addr,offs)  		(OSS_SWAP16(MREAD_D16(addr,offs)))
-#define M199_MWRITE_D32(addr,offs,val)	{M199_MWRITE_D16(addr,offs, (val & 0xffff)); \
-										M199_MWRITE_D16(addr,offs + 2,(val>>16) & 0xffff);}
+/* register access, counted in the statistics of llHdl. The counters are
+ * not locked (the ISR and unlocked paths count as well), so they are
+ * approximate if the device is used concurrently. */
+#define M199_MWRITE_D16(addr,offs,val)  (llHdl->statD16Wr++, \
+										 MWRITE_D16(addr,offs,OSS_SWAP16((val))))
+#define M199_MREAD_D16(addr,offs)  		(llHdl->statD16Rd++, \
+										 M199_MRead16((addr),(offs)))
+#define M199_MWRITE_D32(addr,offs,val)	{M199_MWRITE_D16(addr,offs, ((val) & 0xffff)); \
+										M199_MWRITE_D16(addr,(offs) + 2,((val)>>16) & 0xffff);}
 #define M199_MREAD_D32(addr,offs)		(((u_int32)M199_MREAD_D16(addr,offs))\
-									 	+ (((u_int32)M199_MREAD_D16(addr,offs + 2 ))<<16))
+									 	+ (((u_int32)M199_MREAD_D16(addr,(offs) + 2 ))<<16))
+
+/* Internal locking (LL_LOCK_NONE): each indexed port or shared state has
+ * its own semaphore (see M199_CodeSem). Order: channel before interrupt
+ * configuration before SDRAM port. */
+#define LOCK(llHdl,sem)		OSS_SemWait((llHdl)->osHdl, (llHdl)->sem, \
+										OSS_SEM_WAITFOREVER)
+#define UNLOCK(llHdl,sem)	OSS_SemSignal((llHdl)->osHdl, (llHdl)->sem)
+
+/* The A08 SDRAM address/data port is shared by all channels, the A24 window
+ * is accessed directly */
+#ifdef M199_A24
+# define SDRAM_LOCK(llHdl)
+# define SDRAM_UNLOCK(llHdl)
+#else
+# define SDRAM_LOCK(llHdl)	LOCK(llHdl,sdramSemHdl)
+# define SDRAM_UNLOCK(llHdl) UNLOCK(llHdl,sdramSemHdl)
+#endif /* M199_A24 */
+
+/* Raw SDRAM data access: transfers the bus bytes in memory order.
+ * The SDRAM buffer words are the bus words swapped (see M199_MREAD_D16).
+ * With MAC_BYTESWAP the swap of maccess.h already gives this order, so the
+ * swapped variants access memory mapped windows directly and need no swap
+ * at all. The other variants swap the whole buffer once (M199_SwapBuf). */
+#if defined(MAC_BYTESWAP) && defined(MAC_MEM_MAPPED) && !defined(M199_SIM)
+# define SDRAM_RD16(ma,offs)		(*(volatile u_int16*)((U_INT32_OR_64)(ma)+(offs)))
+# define SDRAM_WR16(ma,offs,val)	(*(volatile u_int16*)((U_INT32_OR_64)(ma)+(offs)) = (val))
+# define SDRAM_RD32(ma,offs)		(*(volatile u_int32*)((U_INT32_OR_64)(ma)+(offs)))
+# define SDRAM_WR32(ma,offs,val)	(*(volatile u_int32*)((U_INT32_OR_64)(ma)+(offs)) = (val))
+#elif defined(MAC_BYTESWAP)
+# define SDRAM_RD16(ma,offs)		M199_MRead16((ma),(offs))
+# define SDRAM_WR16(ma,offs,val)	MWRITE_D16(ma,offs,OSS_SWAP16((val)))
+# define SDRAM_RD32(ma,offs)		M199_MRead32((ma),(offs))
+# define SDRAM_WR32(ma,offs,val)	MWRITE_D32(ma,offs,OSS_SWAP32((val)))
+# ifdef M199_A24
+#  define SDRAM_MREAD32				/* needs M199_MRead32 */
+# endif
+#else
+# define SDRAM_RD16(ma,offs)		((u_int16)MREAD_D16(ma,offs))
+# define SDRAM_WR16(ma,offs,val)	MWRITE_D16(ma,offs,(val))
+# define SDRAM_RD32(ma,offs)		((u_int32)MREAD_D32(ma,offs))
+# define SDRAM_WR32(ma,offs,val)	MWRITE_D32(ma,offs,(val))
+# define SDRAM_SWAP					/* buffer must be swapped */
+#endif
 
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
+/** low-level handle, declared ahead so that its definition below can use
+ *  the constants of the driver header */
+typedef struct LL_HANDLE LL_HANDLE;
+
+/* include files which need LL_HANDLE */
+#include <MEN/ll_entry.h>   /* low-level driver jump table  */
+#include <MEN/m199_drv.h>   /* M199 driver header file */
+
+/** asynchronous SDRAM transfer, followed by its data */
+typedef struct ASYNC_REQ {
+	struct ASYNC_REQ *next;			/**< Next request (submit order) */
+	OSS_SEM_HANDLE	*doneSemHdl;	/**< Signaled on completion */
+	u_int32			gotsize;		/**< Allocated size */
+	int32			ch;				/**< Channel */
+	u_int32			tag;			/**< Caller's tag */
+	u_int32			flags;			/**< M199_ASYNC_xxx flags */
+	u_int32			offset;			/**< Offset in channel area [bytes] */
+	u_int32			size;			/**< Size [bytes] */
+	u_int32			done;			/**< Bytes transferred */
+	u_int32			queued;			/**< Not yet completed by the worker */
+	u_int32			waiting;		/**< A caller waits for it */
+	u_int32			verify;			/**< Write is verified */
+	u_int32			vfyErr;			/**< Mismatches so far */
+	u_int32			vfyOffs;		/**< First mismatch [bytes] */
+	int32			error;			/**< Transfer result */
+}ASYNC_REQ;
+
+/** data of an asynchronous transfer */
+#define ASYNC_DATA(req)		((u_int16*)((req) + 1))
+/** read back buffer of a verified write (ASYNC_CHUNK words after the data) */
+#define ASYNC_VFY(req)		(ASYNC_DATA(req) + (req)->size/2)
+
 /** low-level handle */
-typedef struct {
+struct LL_HANDLE {
 	/* general */
     int32           memAlloc;		/**< Size allocated for the handle */
     OSS_HANDLE      *osHdl;         /**< OSS handle */
     OSS_IRQ_HANDLE  *irqHdl;        /**< IRQ handle */
+    OSS_SEM_HANDLE  *devSemHdl;     /**< Device semaphore handle */
+    OSS_SEM_HANDLE  *cfgSemHdl;     /**< Irq/signal config lock */
+    OSS_SEM_HANDLE  *flashSemHdl;   /**< Flash port lock */
+    OSS_SEM_HANDLE  *eepromSemHdl;  /**< USM EEPROM and ID PROM lock */
+    OSS_SEM_HANDLE  *sdramSemHdl;   /**< A08 SDRAM port lock */
     DESC_HANDLE     *descHdl;       /**< DESC handle */
     MACCESS         ma;             /**< HW access handle */
 	MDIS_IDENT_FUNCT_TBL idFuncTbl;	/**< ID function table */
@@ -98,14 +210,91 @@ typedef struct {
 	/* misc */
     u_int32         irqCount;       /**< Interrupt counter */
     u_int32         idCheck;		/**< ID check enabled */
-} LL_HANDLE;
-
-/* include files which need LL_HANDLE */
-#include <MEN/ll_entry.h>   /* low-level driver jump table  */
-#include <MEN/m199_drv.h>   /* M199 driver header file */
+	u_int32			usmWrCount;		/**< USM words written by last write */
+	u_int32			usmCache;		/**< USM EEPROM shadow enabled */
+	u_int32			usmValid;		/**< USM EEPROM shadow valid */
+	u_int16			usmShadow[M199_USM_SIZE]; /**< USM EEPROM shadow */
+	u_int16			fpgaHdr[M199_FPGA_HEADER_SIZE]; /**< FPGA header, read at
+													 init */
+	/* flash */
+	u_int32			flashSize;		/**< Flash size [bytes] */
+	u_int32			flashAddrHi;	/**< Flash address bits 31..16 last
+										 written (FLASH_ADDR_UNKNOWN) */
+	u_int32			flashSectSize;	/**< Flash sector size [bytes] */
+	u_int32			flashSectDone;	/**< Flash prog: sectors processed */
+	u_int32			flashSectSkip;	/**< Flash prog: sectors skipped */
+	u_int32			flashSectProg;	/**< Flash prog: sectors programmed */
+	u_int32			flashBytesDone;	/**< Flash prog: bytes processed */
+	u_int32			flashErrOffs;	/**< Flash prog: last error offset */
+	u_int32			flashErrStat;	/**< Flash prog: last error status */
+	/* interrupt */
+	u_int32			irqMask;		/**< Sources enabled by M_MK_IRQ_ENABLE */
+	u_int32			irqIer;			/**< Current IER value */
+	u_int32			irqSrcCount[M199_IRQ_SRC_NUM]; /**< Count per source */
+	u_int32			irqEvIrr[IRQ_EVQ_SIZE];	/**< Event queue: sources */
+	u_int32			irqEvTick[IRQ_EVQ_SIZE];/**< Event queue: time stamps */
+	u_int32			irqEvIn;		/**< Queue write index */
+	u_int32			irqEvOut;		/**< Queue read index */
+	u_int32			irqEvNum;		/**< Number of queued events */
+	u_int32			irqEvLost;		/**< Events lost (queue full) */
+	OSS_SEM_HANDLE	*irqSemHdl;		/**< Counts queued events */
+	OSS_SIG_HANDLE	*sigHdl;		/**< Signal for interrupt events */
+	/* sdram */
+	u_int32			chNum;			/**< Number of SDRAM channels */
+	u_int32			chBase[M199_CH_MAX];	/**< Channel SDRAM base [bytes] */
+	u_int32			chSize[M199_CH_MAX];	/**< Channel SDRAM size [bytes] */
+	u_int32			chReg[M199_CH_MAX];	/**< Channel user register offset */
+	u_int32			chRegWidth[M199_CH_MAX]; /**< Channel user register width
+											 [bytes], 0=none */
+	u_int32			chPos[M199_CH_MAX];	/**< Channel block i/o position */
+	OSS_SEM_HANDLE	*chSemHdl[M199_CH_MAX]; /**< Channel lock */
+	u_int32			chVerify[M199_CH_MAX]; /**< Channel verifies writes */
+	u_int32			chVfyErr[M199_CH_MAX]; /**< Mismatches of last write */
+	u_int32			chVfyOffs[M199_CH_MAX]; /**< First mismatch of last write */
+	u_int32			sdramPhys;		/**< Physical address of the A24
+										 window (0=unknown) */
+	/* asynchronous transfers */
+	OSS_TIMER_HANDLE *asyncTimHdl;	/**< Worker timer */
+	OSS_SPINL_HANDLE *asyncSplHdl;	/**< Request list lock */
+	OSS_SIG_HANDLE	*asyncSigHdl;	/**< Signal for completions */
+	ASYNC_REQ		*asyncList;		/**< Requests in submit order */
+	u_int32			asyncNum;		/**< Number of requests */
+	u_int32			asyncRun;		/**< Worker timer started */
+	u_int32			asyncBusy;		/**< Worker callback running */
+	u_int32			asyncStop;		/**< Worker must not restart */
+	/* statistics (see M199_STATS) */
+	u_int32			statD16Rd;		/**< D16 read cycles */
+	u_int32			statD16Wr;		/**< D16 write cycles */
+	u_int32			statD32Rd;		/**< D32 read cycles */
+	u_int32			statD32Wr;		/**< D32 write cycles */
+	u_int32			statSdramAddr;	/**< SDRAM address register writes */
+	u_int32			statFlashAddr;	/**< Flash address register writes */
+	u_int32			statSdramRd;	/**< SDRAM bytes read */
+	u_int32			statSdramWr;	/**< SDRAM bytes written */
+	u_int32			statFlashRd;	/**< Flash bytes read */
+	u_int32			statFlashWr;	/**< Flash bytes programmed */
+	u_int32			statUsmRd;		/**< USM EEPROM bytes read */
+	u_int32			statUsmWr;		/**< USM EEPROM bytes written */
+	u_int32			statBlkRdCalls;	/**< M199_BlockRead calls */
+	u_int32			statBlkRdTicks;	/**< M199_BlockRead ticks */
+	u_int32			statBlkWrCalls;	/**< M199_BlockWrite calls */
+	u_int32			statBlkWrTicks;	/**< M199_BlockWrite ticks */
+	u_int32			statSetCalls[M199_STAT_CODE_NUM]; /**< Setstat calls per code */
+	u_int32			statSetTicks[M199_STAT_CODE_NUM]; /**< Setstat ticks per code */
+	u_int32			statGetCalls[M199_STAT_CODE_NUM]; /**< Getstat calls per code */
+	u_int32			statGetTicks[M199_STAT_CODE_NUM]; /**< Getstat ticks per code */
+};
 
 static const char IdentString[]=MENT_XSTR(MAK_REVISION);
 
+/** CRC-32 (IEEE 802.3, reflected) table for one nibble */
+static const u_int32 G_crcTab[16] = {
+	0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+	0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+	0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+	0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
 /*-----------------------------------------+
 |  PROTOTYPES                              |
 +-----------------------------------------*/
@@ -117,6 +306,10 @@ static int32 M199_Read(LL_HANDLE *llHdl, int32 ch, int32 *value);
 static int32 M199_Write(LL_HANDLE *llHdl, int32 ch, int32 value);
 static int32 M199_SetStat(LL_HANDLE *llHdl,int32 ch, int32 code, INT32_OR_64 value32_or_64);
 static int32 M199_GetStat(LL_HANDLE *llHdl, int32 ch, int32 code, INT32_OR_64 *value32_or_64P);
+static int32 M199_SetStatCode(LL_HANDLE *llHdl, int32 code, int32 ch,
+							  INT32_OR_64 value32_or_64);
+static int32 M199_GetStatCode(LL_HANDLE *llHdl, int32 code, int32 ch,
+							  INT32_OR_64 *value32_or_64P);
 static int32 M199_BlockRead(LL_HANDLE *llHdl, int32 ch, void *buf, int32 size,
 							int32 *nbrRdBytesP);
 static int32 M199_BlockWrite(LL_HANDLE *llHdl, int32 ch, void *buf, int32 size,
@@ -126,6 +319,54 @@ static int32 M199_Info(int32 infoType, ... );
 
 static char* M199_Ident( void );
 static int32 M199_Cleanup(LL_HANDLE *llHdl, int32 retCode);
+static void M199_SdramRead(LL_HANDLE *llHdl, u_int32 offset, u_int16 *buf,
+						   u_int32 nWords, int32 setAddr);
+static void M199_SdramWrite(LL_HANDLE *llHdl, u_int32 offset, u_int16 *buf,
+							u_int32 nWords, int32 setAddr);
+static int32 M199_SdramSg(LL_HANDLE *llHdl, int32 ch, M_SG_BLOCK *blk,
+						  int32 write);
+static int32 M199_SdramChInit(LL_HANDLE *llHdl);
+static int32 M199_UserChInit(LL_HANDLE *llHdl);
+static OSS_SEM_HANDLE *M199_CodeSem(LL_HANDLE *llHdl, int32 code, int32 ch);
+static int32 M199_SdramVerify(LL_HANDLE *llHdl, int32 ch, u_int32 offset,
+							  u_int16 *buf, u_int32 nWords);
+static int32 M199_SdramTest(LL_HANDLE *llHdl, int32 ch, M199_SDRAM_TEST *t);
+static void M199_SdramFill(LL_HANDLE *llHdl, u_int32 offset, u_int16 *pat,
+						   u_int32 nWords);
+static int32 M199_SdramCopy(LL_HANDLE *llHdl, u_int32 dst, u_int32 src,
+							u_int32 nWords);
+static int32 M199_SdramCheck(LL_HANDLE *llHdl, int32 ch, M199_SDRAM_CHECK *chk);
+static int32 M199_SdramFind(LL_HANDLE *llHdl, int32 ch, M199_SDRAM_FIND *find);
+static u_int16 M199_TestWord(u_int32 test, u_int32 pass, u_int32 idx,
+							 u_int32 *rndP);
+static int32 M199_AsyncSubmit(LL_HANDLE *llHdl, int32 ch, M_SG_BLOCK *blk);
+static int32 M199_AsyncWait(LL_HANDLE *llHdl, int32 ch, M_SG_BLOCK *blk);
+static void M199_AsyncWork(void *arg);
+static void M199_AsyncDone(LL_HANDLE *llHdl, ASYNC_REQ *req, int32 error);
+static void M199_AsyncAbort(LL_HANDLE *llHdl, int32 error);
+static void M199_AsyncFree(LL_HANDLE *llHdl, ASYNC_REQ *req);
+static int32 M199_CmdList(LL_HANDLE *llHdl, int32 ch, M_SG_BLOCK *blk);
+static int32 M199_UserCheck(u_int32 offset, u_int32 size);
+static int32 M199_UserReg(LL_HANDLE *llHdl, M_SG_BLOCK *blk, int32 write);
+static int32 M199_RegWait(LL_HANDLE *llHdl, M199_REG_WAIT *rw);
+static int32 M199_IrqWait(LL_HANDLE *llHdl, M199_IRQ_WAIT *wait);
+static void M199_IrqClear(LL_HANDLE *llHdl);
+static int32 M199_UsmWrite(LL_HANDLE *llHdl, u_int16 *dataP, int32 update);
+static void M199_UsmRead(LL_HANDLE *llHdl, u_int32 offset, u_int32 count,
+						 u_int16 *dataP);
+static void M199_FlashAddr(LL_HANDLE *llHdl, u_int32 addr);
+static u_int32 M199_FlashRead(LL_HANDLE *llHdl, u_int32 offset, u_int16 *dataP,
+							  u_int32 nWords);
+static int32 M199_FlashWait(LL_HANDLE *llHdl, u_int32 offset, int32 timeout);
+static int32 M199_FlashProg(LL_HANDLE *llHdl, M199_FLASH_PROG *fp);
+static u_int16 M199_MRead16(MACCESS ma, u_int32 offs);
+static void M199_StatsGet(LL_HANDLE *llHdl, M199_STATS *st);
+#ifdef SDRAM_MREAD32
+static u_int32 M199_MRead32(MACCESS ma, u_int32 offs);
+#endif
+#ifdef SDRAM_SWAP
+static void M199_SwapBuf(u_int16 *buf, u_int32 nWords);
+#endif
 
 /****************************** M199_GetEntry *********************************/
 /** Initialize driver's jump table
@@ -160,8 +401,22 @@ extern void M199_GetEntry( LL_ENTRY* drvP )
  * DEBUG_LEVEL           OSS_DBG_DEFAULT  see dbg.h
  * ID_CHECK              TRUE             TRUE/FALSE
  * LED                   127              0..127
+ * IRQ_MASK              0xffffffff       0..0xffffffff
+ * USM_CACHE             FALSE            TRUE/FALSE
+ * FLASH_SIZE            0x1000000        flash size [bytes]
+ * FLASH_SECT_SIZE       0x20000          flash sector size [bytes]
+ * SDRAM_CH_NUM          1                1..16
+ * CHANNEL_n/SDRAM_BASE  n*part           SDRAM base of channel n [bytes]
+ * CHANNEL_n/SDRAM_SIZE  part             SDRAM size of channel n [bytes]
+ * CHANNEL_n/USER_REG    none             user register of channel n
+ * CHANNEL_n/USER_WIDTH  2                2 (D16), 4 (D32)
+ * SDRAM_PHYS_ADDR       0 (unknown)      physical address of the A24
+ *                                        window (M199_BLK_SDRAM_MAP)
  * \endcode
  *
+ * part is the SDRAM size divided by SDRAM_CH_NUM. The channels must not
+ * overlap.
+ *
  * The function decodes \ref descriptor_entries "these descriptor entries"
  * in addition to the general descriptor keys.
  *
@@ -186,7 +441,7 @@ static int32 M199_Init(
     LL_HANDLE *llHdl = NULL;
     u_int32 gotsize;
     int32 retCode;
-    u_int32 value;
+    u_int32 value, ch;
 
     /*------------------------------+
     |  prepare the handle           |
@@ -206,6 +461,7 @@ static int32 M199_Init(
     llHdl->memAlloc   = gotsize;
     llHdl->osHdl      = osHdl;
     llHdl->irqHdl     = irqHdl;
+    llHdl->devSemHdl  = devSemHdl;
     llHdl->ma		  = *ma;
 
     /*------------------------------+
@@ -299,6 +555,108 @@ static int32 M199_Init(
 	}
 	M199_MWRITE_D16( llHdl->ma, M199_LED_REG , (u_int16)(value & 0x7F) );
 
+	/* interrupt sources enabled by M_MK_IRQ_ENABLE */
+    retCode = DESC_GetUInt32(llHdl->descHdl,
+    						 0xFFFFFFFF,
+					 		 &llHdl->irqMask,
+					 		 "IRQ_MASK");
+    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+		DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"IRQ_MASK\" = 0x%08lx\n",retCode));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
+	/* SDRAM channels */
+	retCode = M199_SdramChInit(llHdl);
+	if (retCode){
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
+	/* physical address of the SDRAM window (M199_BLK_SDRAM_MAP) */
+    retCode = DESC_GetUInt32(llHdl->descHdl,
+    						 0,
+					 		 &llHdl->sdramPhys,
+					 		 "SDRAM_PHYS_ADDR");
+    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+		DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"SDRAM_PHYS_ADDR\" = 0x%08lx\n",retCode));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
+	/* channel user registers (M_read/M_write) */
+	retCode = M199_UserChInit(llHdl);
+	if (retCode){
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
+	/* flash */
+    retCode = DESC_GetUInt32(llHdl->descHdl,
+    						 0x1000000,
+					 		 &llHdl->flashSize,
+					 		 "FLASH_SIZE");
+    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+		DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"FLASH_SIZE\" = 0x%08lx\n",retCode));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+    retCode = DESC_GetUInt32(llHdl->descHdl,
+    						 0x20000,
+					 		 &llHdl->flashSectSize,
+					 		 "FLASH_SECT_SIZE");
+    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+		DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"FLASH_SECT_SIZE\" = 0x%08lx\n",retCode));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+	if( llHdl->flashSectSize == 0 || (llHdl->flashSectSize & 1) ){
+		DBGWRT_ERR(( DBH, " *** M199_Init: illegal FLASH_SECT_SIZE\n"));
+		return( M199_Cleanup(llHdl,ERR_LL_DESC_PARAM) );
+	}
+	llHdl->flashAddrHi = FLASH_ADDR_UNKNOWN;
+
+	/* FPGA header */
+	M199_FlashRead(llHdl, 0, llHdl->fpgaHdr, M199_FPGA_HEADER_SIZE);
+
+	/* USM EEPROM shadow */
+    retCode = DESC_GetUInt32(llHdl->descHdl,
+    						 FALSE,
+					 		 &llHdl->usmCache,
+					 		 "USM_CACHE");
+    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+		DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"USM_CACHE\" = 0x%08lx\n",retCode));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
+	/* interrupt disabled, event queue empty */
+	llHdl->irqIer = 0;
+	M199_MWRITE_D32( llHdl->ma, M199_IRQ_IER, 0 );
+	retCode = OSS_SemCreate(osHdl, OSS_SEM_COUNT, 0, &llHdl->irqSemHdl);
+	if (retCode){
+		DBGWRT_ERR(( DBH, " *** M199_Init: can't create irq semaphore\n"));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
+	/* locks */
+	retCode = OSS_SemCreate(osHdl, OSS_SEM_BIN, 1, &llHdl->cfgSemHdl);
+	if (!retCode)
+		retCode = OSS_SemCreate(osHdl, OSS_SEM_BIN, 1, &llHdl->flashSemHdl);
+	if (!retCode)
+		retCode = OSS_SemCreate(osHdl, OSS_SEM_BIN, 1, &llHdl->eepromSemHdl);
+	if (!retCode)
+		retCode = OSS_SemCreate(osHdl, OSS_SEM_BIN, 1, &llHdl->sdramSemHdl);
+	for (ch=0; !retCode && ch < llHdl->chNum; ch++)
+		retCode = OSS_SemCreate(osHdl, OSS_SEM_BIN, 1, &llHdl->chSemHdl[ch]);
+	if (retCode){
+		DBGWRT_ERR(( DBH, " *** M199_Init: can't create lock semaphores\n"));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
+	/* asynchronous transfers */
+	retCode = OSS_SpinLockCreate(osHdl, &llHdl->asyncSplHdl);
+	if (!retCode)
+		retCode = OSS_TimerCreate(osHdl, M199_AsyncWork, (void*)llHdl,
+								  &llHdl->asyncTimHdl);
+	if (retCode){
+		DBGWRT_ERR(( DBH, " *** M199_Init: can't create async worker\n"));
+		return( M199_Cleanup(llHdl,retCode) );
+	}
+
 	*llHdlP = llHdl;	/* set low-level driver handle */
 
 	return(ERR_SUCCESS);
@@ -326,7 +684,9 @@ static int32 M199_Exit(
     /*------------------------------+
     |  de-init hardware             |
     +------------------------------*/
-	/* ... */
+	/* disable interrupt */
+	llHdl->irqIer = 0;
+	M199_MWRITE_D32( llHdl->ma, M199_IRQ_IER, 0 );
 
     /*------------------------------+
     |  clean up memory              |
@@ -338,9 +698,12 @@ static int32 M199_Exit(
 } /* M199_Exit */
 
 /****************************** M199_Read *************************************/
-/** Read a value from the device is not supported
+/** Read the user register of the current channel
  *
- *  The function reads a value out of the SDRAM.
+ *  The register is defined by the descriptor keys CHANNEL_n/USER_REG and
+ *  CHANNEL_n/USER_WIDTH. A single register access is not locked and
+ *  not counted in the call statistics, this is the fastest path through
+ *  the driver.
  *
  *  \param llHdl      \IN  Low-level handle
  *  \param ch         \IN  Current channel
@@ -354,19 +717,27 @@ static int32 M199_Read(
     int32 *valueP
 )
 {
-    DBGWRT_ERR((DBH, "LL - M199_Read: Not supported"));
+	if( llHdl->chRegWidth[ch] == 4 )
+		*valueP = (int32)M199_MREAD_D32(llHdl->ma, llHdl->chReg[ch]);
+	else if( llHdl->chRegWidth[ch] == 2 )
+		*valueP = (int32)M199_MREAD_D16(llHdl->ma, llHdl->chReg[ch]);
+	else {
+		DBGWRT_ERR((DBH, " *** M199_Read: no user register on channel %d\n",
+					ch));
+		return(ERR_LL_ILL_CHAN);
+	}
 
 	return(ERR_SUCCESS);
 }/* M199_Read */
 
 /****************************** M199_Write ************************************/
-/** Write a value to the device is not supported
+/** Write the user register of the current channel
  *
- *  The function writes a value to the SDRAM.
+ *  See M199_Read(). A D16 register gets the lower 16 bits of the value.
  *
  *  \param llHdl      \IN  Low-level handle
  *  \param ch         \IN  Current channel
- *  \param value      \IN  Read value
+ *  \param value      \IN  Value to write
  *
  *  \return           \c 0 on success or error code
  ******************************************************************************/
@@ -376,7 +747,15 @@ static int32 M199_Write(
     int32 value
 )
 {
-    DBGWRT_ERR((DBH, "LL - M199_Write: Not supported"));
+	if( llHdl->chRegWidth[ch] == 4 )
+		M199_MWRITE_D32(llHdl->ma, llHdl->chReg[ch], (u_int32)value)
+	else if( llHdl->chRegWidth[ch] == 2 )
+		M199_MWRITE_D16(llHdl->ma, llHdl->chReg[ch], (u_int16)value);
+	else {
+		DBGWRT_ERR((DBH, " *** M199_Write: no user register on channel %d\n",
+					ch));
+		return(ERR_LL_ILL_CHAN);
+	}
 
 	return(ERR_SUCCESS);
 } /* M199_Write */
@@ -401,6 +780,39 @@ static int32 M199_SetStat(
     int32  ch,
     INT32_OR_64  value32_or_64
 )
+{
+	u_int32 start = OSS_TickGet(llHdl->osHdl);
+	u_int32 slot  = M199_STAT_SLOT(code);
+	OSS_SEM_HANDLE *sem = M199_CodeSem(llHdl, code, ch);
+	int32 error;
+
+	if( sem )
+		OSS_SemWait(llHdl->osHdl, sem, OSS_SEM_WAITFOREVER);
+	error = M199_SetStatCode(llHdl, code, ch, value32_or_64);
+	if( sem )
+		OSS_SemSignal(llHdl->osHdl, sem);
+
+	llHdl->statSetCalls[slot]++;
+	llHdl->statSetTicks[slot] += OSS_TickGet(llHdl->osHdl) - start;
+
+	return(error);
+} /* M199_SetStat */
+
+/**************************** M199_SetStatCode ********************************/
+/** Set the driver status, called by M199_SetStat
+ *
+ *  \param llHdl  	  \IN  Low-level handle
+ *  \param code       \IN  Status code
+ *  \param ch         \IN  Current channel
+ *  \param value32_or_64  \IN  Data or pointer to block data structure
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_SetStatCode(
+    LL_HANDLE *llHdl,
+    int32  code,
+    int32  ch,
+    INT32_OR_64  value32_or_64
+)
 {
     int32	error  = ERR_SUCCESS;
     int32	value  = (int32)value32_or_64;	/* 32bit value		      */
@@ -420,7 +832,82 @@ static int32 M199_SetStat(
         |  enable interrupts        |
         +--------------------------*/
         case M_MK_IRQ_ENABLE:
-			M199_MWRITE_D32(llHdl->ma,M199_IRQ_IER,value);
+			llHdl->irqIer = value ? llHdl->irqMask : 0;
+			M199_MWRITE_D32(llHdl->ma,M199_IRQ_IER,llHdl->irqIer);
+			break;
+        /*--------------------------+
+        |  enabled irq sources      |
+        +--------------------------*/
+        case M199_IRQ_MASK:
+			llHdl->irqMask = (u_int32)value;
+			if( llHdl->irqIer ){
+				llHdl->irqIer = llHdl->irqMask;
+				M199_MWRITE_D32(llHdl->ma,M199_IRQ_IER,llHdl->irqIer);
+			}
+			break;
+        /*--------------------------+
+        |  install signal           |
+        +--------------------------*/
+        case M199_SIG_SET:
+			if( llHdl->sigHdl ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: signal already installed\n"));
+				return(ERR_OSS_SIG_SET);
+			}
+			error = OSS_SigCreate(llHdl->osHdl, value, &llHdl->sigHdl);
+			break;
+        /*--------------------------+
+        |  remove signal            |
+        +--------------------------*/
+        case M199_SIG_CLR:
+			if( llHdl->sigHdl == NULL ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: signal not installed\n"));
+				return(ERR_OSS_SIG_CLR);
+			}
+			error = OSS_SigRemove(llHdl->osHdl, &llHdl->sigHdl);
+			break;
+        /*--------------------------+
+        |  install async signal     |
+        +--------------------------*/
+        case M199_ASYNC_SIG_SET:
+        {
+			OSS_SIG_HANDLE *sigHdl = NULL;
+
+			if( llHdl->asyncSigHdl ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: signal already installed\n"));
+				return(ERR_OSS_SIG_SET);
+			}
+			error = OSS_SigCreate(llHdl->osHdl, value, &sigHdl);
+			if( error )
+				break;
+			/* the worker sends it under the request list lock */
+			OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+			llHdl->asyncSigHdl = sigHdl;
+			OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+			break;
+        }
+        /*--------------------------+
+        |  remove async signal      |
+        +--------------------------*/
+        case M199_ASYNC_SIG_CLR:
+        {
+			OSS_SIG_HANDLE *sigHdl;
+
+			OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+			sigHdl = llHdl->asyncSigHdl;
+			llHdl->asyncSigHdl = NULL;
+			OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+			if( sigHdl == NULL ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: signal not installed\n"));
+				return(ERR_OSS_SIG_CLR);
+			}
+			error = OSS_SigRemove(llHdl->osHdl, &sigHdl);
+			break;
+        }
+        /*--------------------------+
+        |  clear irq events/count   |
+        +--------------------------*/
+        case M199_IRQ_CLR:
+			M199_IrqClear(llHdl);
 			break;
         /*--------------------------+
         |  set irq counter          |
@@ -429,25 +916,59 @@ static int32 M199_SetStat(
             llHdl->irqCount = value;
             break;
         /*--------------------------+
+        |  program flash            |
+        +--------------------------*/
+        case M199_BLK_FLASH_PROG:
+        {
+            M_SG_BLOCK *blk = (M_SG_BLOCK*)valueP;
+			M199_FLASH_PROG *fp = (M199_FLASH_PROG*)blk->data;
+
+			if( blk->size < M199_FLASH_PROG_MINSIZE ||
+				(u_int32)blk->size - M199_FLASH_PROG_MINSIZE < fp->size ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( (fp->offset % llHdl->flashSectSize) || (fp->size & 1) ||
+				fp->offset > llHdl->flashSize ||
+				fp->size > llHdl->flashSize - fp->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: illegal flash range\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
+			error = M199_FlashProg(llHdl, fp);
+			break;
+		}
+        /*--------------------------+
         |  set usm-module data      |
         +--------------------------*/
         case M199_BLK_USM_MODULE:
+        case M199_BLK_USM_UPDATE:
         {
-            u_int8 n;
             M_SG_BLOCK *blk = (M_SG_BLOCK*)valueP;
-            u_int16 *dataP = (u_int16*)blk->data;
 
-			if (blk->size < 256)		/* check buf size */
+			if (blk->size < M199_USM_SIZE*2)		/* check buf size */
 				return(ERR_LL_USERBUF);
-			for(n = 0; n < 128; n++)
-			{
-	            usm_write((u_int8 *)llHdl->ma,n,(u_int16)(*(dataP+n)));
-	            OSS_Delay(llHdl->osHdl, 12);
-
-			}
+			error = M199_UsmWrite(llHdl, (u_int16*)blk->data,
+								  (code == M199_BLK_USM_UPDATE));
 			break;
 		}
         /*--------------------------+
+        |  usm eeprom shadow        |
+        +--------------------------*/
+        case M199_USM_CACHE:
+			llHdl->usmCache = value ? TRUE : FALSE;
+			llHdl->usmValid = FALSE;
+			break;
+        /*--------------------------+
+        |  reset statistics         |
+        +--------------------------*/
+        case M199_STATS_RESET:
+			/* statistics are the last members of the handle */
+			OSS_MemFill(llHdl->osHdl,
+						(u_int32)((char*)&llHdl->statGetTicks[M199_STAT_CODE_NUM] -
+								  (char*)&llHdl->statD16Rd),
+						(char*)&llHdl->statD16Rd, 0x00);
+			break;
+        /*--------------------------+
         |  set LEDs                 |
         +--------------------------*/
         case M199_LED:
@@ -456,31 +977,130 @@ static int32 M199_SetStat(
         	break;
         }
         /*--------------------------+
+        |  sdram block i/o position |
+        +--------------------------*/
+        case M199_SDRAM_POS:
+        {
+			if( ((u_int32)value & 1) || ((u_int32)value > llHdl->chSize[ch]) ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: illegal SDRAM position "
+							 "0x%08x\n", value));
+				return(ERR_LL_ILL_PARAM);
+			}
+			llHdl->chPos[ch] = (u_int32)value;
+        	break;
+        }
+        /*--------------------------+
+        |  verify sdram writes      |
+        +--------------------------*/
+        case M199_SDRAM_VERIFY:
+			llHdl->chVerify[ch] = value ? TRUE : FALSE;
+        	break;
+        /*--------------------------+
         |  set sdram data           |
         +--------------------------*/
         case M199_BLK_SDRAM:
         {
-        	u_int32 n;
 			M_SG_BLOCK *blk = (M_SG_BLOCK*)valueP;
 			M199_SDRAM_ACCESS *blksd = (M199_SDRAM_ACCESS*)blk->data;
-			if( blk->size < M199_SDRAM_ACCESS_MINSIZE ){
+			if( blk->size < M199_SDRAM_ACCESS_MINSIZE ||
+				(u_int32)blk->size - M199_SDRAM_ACCESS_MINSIZE < blksd->size ){
 				DBGWRT_ERR(( DBH, " *** M199_Setstat: Block size too small\n"));
 				return(ERR_LL_USERBUF);
 			}
+			if( blksd->offset > llHdl->chSize[ch] ||
+				blksd->size > llHdl->chSize[ch] - blksd->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: illegal SDRAM range\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
 
-#ifdef M199_A24
-			for (n=0; n < (blksd->size/2); n++){	/* write blksd->size/2 words */
-				M199_MWRITE_D16(llHdl->ma, ((blksd->offset) + (n*2)), ((blksd->buf[n])));
+			SDRAM_LOCK(llHdl);
+			M199_SdramWrite(llHdl, llHdl->chBase[ch] + blksd->offset,
+							blksd->buf, blksd->size/2, TRUE);
+			SDRAM_UNLOCK(llHdl);
+
+			if( llHdl->chVerify[ch] ){
+				llHdl->chVfyErr[ch] = 0;
+				error = M199_SdramVerify(llHdl, ch, blksd->offset, blksd->buf,
+										 blksd->size/2);
+			}
+        	break;
+        }
+        /*--------------------------+
+        |  set sdram segments       |
+        +--------------------------*/
+        case M199_BLK_SDRAM_SG:
+			error = M199_SdramSg(llHdl, ch, (M_SG_BLOCK*)valueP, TRUE);
+			break;
+        /*--------------------------+
+        |  queue sdram transfer     |
+        +--------------------------*/
+        case M199_BLK_ASYNC_SUBMIT:
+			error = M199_AsyncSubmit(llHdl, ch, (M_SG_BLOCK*)valueP);
+			break;
+        /*--------------------------+
+        |  user module registers    |
+        +--------------------------*/
+        case M199_BLK_USER_REG:
+			error = M199_UserReg(llHdl, (M_SG_BLOCK*)valueP, TRUE);
+			break;
+        /*--------------------------+
+        |  fill sdram               |
+        +--------------------------*/
+        case M199_BLK_SDRAM_FILL:
+        {
+			M_SG_BLOCK *blk = (M_SG_BLOCK*)valueP;
+			M199_SDRAM_FILL *fill = (M199_SDRAM_FILL*)blk->data;
+			u_int16 pat[2];
+
+			if( blk->size < sizeof(M199_SDRAM_FILL) ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
 			}
-#else	/* M199_A24 */
-			/* The written address will be autoincremented in A08 mode          *
-			*  at the M199_SDRAM_ADDR. The data will be sent to next address    *
-			*  if continued writing  											*/
-  			M199_MWRITE_D32(llHdl->ma,M199_SDRAM_ADDR,blksd->offset);
-			for (n=0; n < (blksd->size/2); n++){	/* write blk->size/2 words */
-				M199_MWRITE_D16(llHdl->ma,M199_SDRAM_DATA,(blksd->buf[n]));
+			if( (fill->offset & 1) || (fill->size & 1) ||
+				(fill->width != 2 && fill->width != 4) ||
+				fill->offset > llHdl->chSize[ch] ||
+				fill->size > llHdl->chSize[ch] - fill->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: illegal SDRAM fill\n"));
+				return(ERR_LL_ILL_PARAM);
 			}
-#endif /* M199_A24 */
+			/* 32-bit pattern: words in the order of a u_int32 buffer */
+			if( fill->width == 4 ){
+				u_int32 pat32 = fill->pattern;
+				u_int16 *patP = (u_int16*)&pat32;
+
+				pat[0] = patP[0];
+				pat[1] = patP[1];
+			}
+			else
+				pat[0] = pat[1] = (u_int16)fill->pattern;
+
+			M199_SdramFill(llHdl, llHdl->chBase[ch] + fill->offset, pat,
+						   fill->size/2);
+        	break;
+        }
+        /*--------------------------+
+        |  copy sdram               |
+        +--------------------------*/
+        case M199_BLK_SDRAM_COPY:
+        {
+			M_SG_BLOCK *blk = (M_SG_BLOCK*)valueP;
+			M199_SDRAM_COPY *cp = (M199_SDRAM_COPY*)blk->data;
+
+			if( blk->size < sizeof(M199_SDRAM_COPY) ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( ((cp->srcOffset | cp->dstOffset | cp->size) & 1) ||
+				cp->srcOffset > llHdl->chSize[ch] ||
+				cp->size > llHdl->chSize[ch] - cp->srcOffset ||
+				cp->dstOffset > llHdl->chSize[ch] ||
+				cp->size > llHdl->chSize[ch] - cp->dstOffset ){
+				DBGWRT_ERR(( DBH, " *** M199_Setstat: illegal SDRAM copy\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
+			error = M199_SdramCopy(llHdl, llHdl->chBase[ch] + cp->dstOffset,
+								   llHdl->chBase[ch] + cp->srcOffset,
+								   cp->size/2);
         	break;
         }
         /*--------------------------+
@@ -491,7 +1111,7 @@ static int32 M199_SetStat(
     }
 
 	return(error);
-} /*M199_SetStat */
+} /* M199_SetStatCode */
 
 /****************************** M199_GetStat **********************************/
 /** Get the driver status
@@ -515,6 +1135,40 @@ static int32 M199_GetStat(
     int32  ch,
     INT32_OR_64  *value32_or_64P
 )
+{
+	u_int32 start = OSS_TickGet(llHdl->osHdl);
+	u_int32 slot  = M199_STAT_SLOT(code);
+	OSS_SEM_HANDLE *sem = M199_CodeSem(llHdl, code, ch);
+	int32 error;
+
+	if( sem )
+		OSS_SemWait(llHdl->osHdl, sem, OSS_SEM_WAITFOREVER);
+	error = M199_GetStatCode(llHdl, code, ch, value32_or_64P);
+	if( sem )
+		OSS_SemSignal(llHdl->osHdl, sem);
+
+	llHdl->statGetCalls[slot]++;
+	llHdl->statGetTicks[slot] += OSS_TickGet(llHdl->osHdl) - start;
+
+	return(error);
+} /* M199_GetStat */
+
+/**************************** M199_GetStatCode ********************************/
+/** Get the driver status, called by M199_GetStat
+ *
+ *  \param llHdl      	   \IN  Low-level handle
+ *  \param code       	   \IN  Status code
+ *  \param ch         	   \IN  Current channel
+ *  \param value32_or_64P  \OUT Data pointer or pointer to block data structure
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_GetStatCode(
+    LL_HANDLE *llHdl,
+    int32  code,
+    int32  ch,
+    INT32_OR_64  *value32_or_64P
+)
 {
     int32	*valueP       = (int32*)value32_or_64P;	/* pointer to 32bit value      */
     INT32_OR_64	*value64P     = value32_or_64P;		/* stores 32/64bit pointer     */
@@ -538,17 +1192,44 @@ static int32 M199_GetStat(
         +--------------------------*/
         case M199_BLK_USM_MODULE:
         {
-        	u_int8 n;
-        	u_int16 *dataP = (u_int16*)blk->data;
-			if (blk->size < 256)		/* check buf size */
+			if (blk->size < M199_USM_SIZE*2)		/* check buf size */
 				return(ERR_LL_USERBUF);
-			for(n = 0; n < 128; n++)
-			{
-	            *dataP++ = (u_int16)usm_read((U_INT32_OR_64)llHdl->ma,n);
+			M199_UsmRead(llHdl, 0, M199_USM_SIZE, (u_int16*)blk->data);
+	        break;
+        }
+        /*--------------------------+
+        |  usm-module words         |
+        +--------------------------*/
+        case M199_BLK_USM_PART:
+        {
+			M199_USM_PART *part = (M199_USM_PART*)blk->data;
+
+			if( blk->size < M199_USM_PART_MINSIZE ||
+				blk->size < M199_USM_PART_MINSIZE + part->count*2 ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( part->offset > M199_USM_SIZE ||
+				part->count > M199_USM_SIZE - part->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: illegal USM range\n"));
+				return(ERR_LL_ILL_PARAM);
 			}
+			M199_UsmRead(llHdl, part->offset, part->count, part->buf);
 	        break;
         }
         /*--------------------------+
+        |  usm eeprom shadow        |
+        +--------------------------*/
+        case M199_USM_CACHE:
+            *valueP = llHdl->usmCache;
+            break;
+        /*--------------------------+
+        |  usm words last written   |
+        +--------------------------*/
+        case M199_USM_WR_COUNT:
+            *valueP = llHdl->usmWrCount;
+            break;
+        /*--------------------------+
         |  onboard Led              |
         +--------------------------*/
         case M199_LED:
@@ -564,63 +1245,313 @@ static int32 M199_GetStat(
 			u_int32 index_i = 0;
 			u_int16 *dataP = (u_int16*)blk->data;
 
-			if (blk->size < 256)		/* check buf size */
+			if (blk->size < M199_FPGA_HEADER_SIZE*2)		/* check buf size */
 				return(ERR_LL_USERBUF);
 
-           	M199_MWRITE_D32( llHdl->ma, M199_FLASH_ADDR , 0 );
-        	M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA , 0xFFFF );	/* READ-MODE */
-
-        	for (index_i = 0; index_i < 128; index_i++)
-        	{
-        		M199_MWRITE_D32( llHdl->ma, M199_FLASH_ADDR ,(index_i*2) );
-        		*dataP++ = (u_int16)OSS_SWAP16(M199_MREAD_D16( llHdl->ma, M199_FLASH_DATA ));
-        	}
+        	for (index_i = 0; index_i < M199_FPGA_HEADER_SIZE; index_i++)
+        		*dataP++ = llHdl->fpgaHdr[index_i];
           	break;
         }
-    	/*--------------------------+
-        |  sdram data               |
+   		/*--------------------------+
+        |  FPGA header decoded      |
         +--------------------------*/
-        case M199_BLK_SDRAM:
+        case M199_BLK_FPGA_INFO:
         {
-        	u_int32 n;
-			M199_SDRAM_ACCESS *blksd = (M199_SDRAM_ACCESS*)blk->data;
-			if( blk->size < M199_SDRAM_ACCESS_MINSIZE ){
+			M199_FPGA_INFO *info = (M199_FPGA_INFO*)blk->data;
+			u_int16 *hdr = llHdl->fpgaHdr;
+			u_int32 n;
+
+			if( blk->size < sizeof(M199_FPGA_INFO) ){
 				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
 				return(ERR_LL_USERBUF);
 			}
 
-#ifdef M199_A24
-			for (n=0; n < (blksd->size/2); n++){		/* read blksd->size/2 words */
-				(blksd->buf[n]) = (u_int16)M199_MREAD_D16(llHdl->ma, ((blksd->offset) + (n*2)));
-			}
-#else /* M199_A24 */
-			/* The written address will be autoincremented in A08 mode          *
-			*  at the M199_SDRAM_ADDR. The data will be read from next address  *
-			*  if continued reading  											*/
-			M199_MWRITE_D32(llHdl->ma,M199_SDRAM_ADDR,blksd->offset);
-			for (n=0; n < (blksd->size/2); n++){		/* read blksd->size/2 words */
-				(blksd->buf[n]) = MREAD_D16(llHdl->ma,M199_SDRAM_DATA);
-				(blksd->buf[n]) = (u_int16)OSS_SWAP16((blksd->buf[n]));
+			info->magic = ((u_int32)hdr[0] << 16) | hdr[1];
+			for (n=0; n < M199_FPGA_NAME_LEN/2; n++){
+				info->fileName[n*2]   = (char)(hdr[2+n] >> 8);
+				info->fileName[n*2+1] = (char)(hdr[2+n] & 0xff);
 			}
-#endif /* M199_A24 */
-        	break;
+			info->fileName[M199_FPGA_NAME_LEN] = '\0';
+			hdr += 2 + M199_FPGA_NAME_LEN/2;
+			for (n=0; n < M199_FPGA_FIELD_NUM; n++)
+				info->field[n] = ((u_int32)hdr[n*2] << 16) | hdr[n*2+1];
+          	break;
         }
-        /*--------------------------+
-        |  number of channels       |
+   		/*--------------------------+
+        |  flash read / checksum    |
         +--------------------------*/
-        case M_LL_CH_NUMBER:
-            *valueP = CH_NUMBER;
-            break;
-        /*--------------------------+
-        |  irq counter              |
+        case M199_BLK_FLASH:
+        {
+			M199_FLASH_ACCESS *fa = (M199_FLASH_ACCESS*)blk->data;
+
+			if( blk->size < M199_FLASH_ACCESS_MINSIZE ||
+				(!(fa->flags & M199_FLASH_SUM_ONLY) &&
+				 (u_int32)blk->size - M199_FLASH_ACCESS_MINSIZE < fa->size) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( (fa->offset & 1) || fa->offset > llHdl->flashSize ||
+				fa->size > llHdl->flashSize - fa->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: illegal flash range\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
+			fa->sum = M199_FlashRead(llHdl, fa->offset,
+									 (fa->flags & M199_FLASH_SUM_ONLY) ?
+									 NULL : fa->buf, fa->size/2);
+          	break;
+        }
+   		/*--------------------------+
+        |  statistics               |
         +--------------------------*/
-        case M_LL_IRQ_COUNT:
-            *valueP = llHdl->irqCount;
-            break;
-        /*--------------------------+
-        |  ID PROM check enabled    |
+        case M199_BLK_STATS:
+        {
+			if( blk->size < sizeof(M199_STATS) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			M199_StatsGet(llHdl, (M199_STATS*)blk->data);
+          	break;
+        }
+   		/*--------------------------+
+        |  flash program progress   |
         +--------------------------*/
-        case M_LL_ID_CHECK:
+        case M199_BLK_FLASH_STAT:
+        {
+			M199_FLASH_STAT *fs;
+
+			if( blk->size < sizeof(M199_FLASH_STAT) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			/* not locked, polled while another path programs */
+			fs = (M199_FLASH_STAT*)blk->data;
+			fs->sectDone       = llHdl->flashSectDone;
+			fs->sectSkipped    = llHdl->flashSectSkip;
+			fs->sectProgrammed = llHdl->flashSectProg;
+			fs->bytesDone      = llHdl->flashBytesDone;
+			fs->errOffset      = llHdl->flashErrOffs;
+			fs->errStatus      = llHdl->flashErrStat;
+          	break;
+        }
+    	/*--------------------------+
+        |  sdram data               |
+        +--------------------------*/
+        case M199_BLK_SDRAM:
+        {
+			M199_SDRAM_ACCESS *blksd = (M199_SDRAM_ACCESS*)blk->data;
+			if( blk->size < M199_SDRAM_ACCESS_MINSIZE ||
+				(u_int32)blk->size - M199_SDRAM_ACCESS_MINSIZE < blksd->size ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( blksd->offset > llHdl->chSize[ch] ||
+				blksd->size > llHdl->chSize[ch] - blksd->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: illegal SDRAM range\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
+
+			SDRAM_LOCK(llHdl);
+			M199_SdramRead(llHdl, llHdl->chBase[ch] + blksd->offset,
+						   blksd->buf, blksd->size/2, TRUE);
+			SDRAM_UNLOCK(llHdl);
+        	break;
+        }
+    	/*--------------------------+
+        |  sdram segments           |
+        +--------------------------*/
+        case M199_BLK_SDRAM_SG:
+			error = M199_SdramSg(llHdl, ch, blk, FALSE);
+			break;
+    	/*--------------------------+
+        |  wait for sdram transfer  |
+        +--------------------------*/
+        case M199_BLK_ASYNC_WAIT:
+			error = M199_AsyncWait(llHdl, ch, blk);
+			break;
+    	/*--------------------------+
+        |  execute command list     |
+        +--------------------------*/
+        case M199_BLK_CMD_LIST:
+			error = M199_CmdList(llHdl, ch, blk);
+			break;
+    	/*--------------------------+
+        |  user module registers    |
+        +--------------------------*/
+        case M199_BLK_USER_REG:
+			error = M199_UserReg(llHdl, blk, FALSE);
+			break;
+    	/*--------------------------+
+        |  wait for register value  |
+        +--------------------------*/
+        case M199_BLK_REG_WAIT:
+			if( blk->size < sizeof(M199_REG_WAIT) )		/* check buf size */
+				return(ERR_LL_USERBUF);
+			error = M199_RegWait(llHdl, (M199_REG_WAIT*)blk->data);
+			break;
+        /*--------------------------+
+        |  sdram block i/o position |
+        +--------------------------*/
+        case M199_SDRAM_POS:
+            *valueP = llHdl->chPos[ch];
+            break;
+        /*--------------------------+
+        |  verify sdram writes      |
+        +--------------------------*/
+        case M199_SDRAM_VERIFY:
+            *valueP = llHdl->chVerify[ch];
+            break;
+        /*--------------------------+
+        |  last write verification  |
+        +--------------------------*/
+        case M199_BLK_VERIFY_STAT:
+        {
+			M199_VERIFY_STAT *vs = (M199_VERIFY_STAT*)blk->data;
+
+			if( blk->size < sizeof(M199_VERIFY_STAT) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			vs->errCount  = llHdl->chVfyErr[ch];
+			vs->errOffset = llHdl->chVfyOffs[ch];
+			break;
+        }
+    	/*--------------------------+
+        |  sdram memory test        |
+        +--------------------------*/
+        case M199_BLK_SDRAM_TEST:
+        {
+			M199_SDRAM_TEST *t = (M199_SDRAM_TEST*)blk->data;
+
+			if( blk->size < sizeof(M199_SDRAM_TEST) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( (t->offset & 1) || (t->size & 1) ||
+				(t->tests & ~M199_SDRAM_TEST_ALL) ||
+				t->offset > llHdl->chSize[ch] ||
+				t->size > llHdl->chSize[ch] - t->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: illegal SDRAM test\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
+			error = M199_SdramTest(llHdl, ch, t);
+			break;
+        }
+    	/*--------------------------+
+        |  sdram checksum/min/max   |
+        +--------------------------*/
+        case M199_BLK_SDRAM_CHECK:
+        {
+			M199_SDRAM_CHECK *chk = (M199_SDRAM_CHECK*)blk->data;
+
+			if( blk->size < sizeof(M199_SDRAM_CHECK) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( (chk->offset & 1) || (chk->size & 1) ||
+				chk->offset > llHdl->chSize[ch] ||
+				chk->size > llHdl->chSize[ch] - chk->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: illegal SDRAM range\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
+			error = M199_SdramCheck(llHdl, ch, chk);
+			break;
+        }
+    	/*--------------------------+
+        |  sdram search             |
+        +--------------------------*/
+        case M199_BLK_SDRAM_FIND:
+        {
+			M199_SDRAM_FIND *find = (M199_SDRAM_FIND*)blk->data;
+
+			if( blk->size < sizeof(M199_SDRAM_FIND) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( (find->offset & 1) || (find->size & 1) ||
+				find->offset > llHdl->chSize[ch] ||
+				find->size > llHdl->chSize[ch] - find->offset ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: illegal SDRAM range\n"));
+				return(ERR_LL_ILL_PARAM);
+			}
+			error = M199_SdramFind(llHdl, ch, find);
+			break;
+        }
+    	/*--------------------------+
+        |  sdram window             |
+        +--------------------------*/
+        case M199_BLK_SDRAM_MAP:
+        {
+#ifdef M199_A24
+			M199_SDRAM_MAP *map = (M199_SDRAM_MAP*)blk->data;
+
+			if( blk->size < sizeof(M199_SDRAM_MAP) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			if( llHdl->sdramPhys == 0 ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: SDRAM_PHYS_ADDR not "
+							 "set\n"));
+				return(ERR_LL_ILL_FUNC);
+			}
+			map->physAddr = llHdl->sdramPhys + llHdl->chBase[ch];
+			map->offset   = llHdl->chBase[ch];
+			map->size     = llHdl->chSize[ch];
+#else
+			DBGWRT_ERR(( DBH, " *** M199_Getstat: SDRAM window requires A24\n"));
+			error = ERR_LL_ILL_FUNC;
+#endif /* M199_A24 */
+			break;
+        }
+        /*--------------------------+
+        |  number of channels       |
+        +--------------------------*/
+        case M_LL_CH_NUMBER:
+            *valueP = llHdl->chNum;
+            break;
+        /*--------------------------+
+        |  irq counter              |
+        +--------------------------*/
+        case M_LL_IRQ_COUNT:
+            *valueP = llHdl->irqCount;
+            break;
+        /*--------------------------+
+        |  enabled irq sources      |
+        +--------------------------*/
+        case M199_IRQ_MASK:
+            *valueP = llHdl->irqMask;
+            break;
+        /*--------------------------+
+        |  wait for irq event       |
+        +--------------------------*/
+        case M199_BLK_IRQ_WAIT:
+        {
+			if( blk->size < sizeof(M199_IRQ_WAIT) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			error = M199_IrqWait(llHdl, (M199_IRQ_WAIT*)blk->data);
+			break;
+        }
+        /*--------------------------+
+        |  irq count per source     |
+        +--------------------------*/
+        case M199_BLK_IRQ_COUNT:
+        {
+			u_int32 n;
+			u_int32 *dataP = (u_int32*)blk->data;
+
+			if( blk->size < (M199_IRQ_SRC_NUM * sizeof(u_int32)) ){
+				DBGWRT_ERR(( DBH, " *** M199_Getstat: Block size too small\n"));
+				return(ERR_LL_USERBUF);
+			}
+			for (n=0; n < M199_IRQ_SRC_NUM; n++)
+				dataP[n] = llHdl->irqSrcCount[n];
+			break;
+        }
+        /*--------------------------+
+        |  ID PROM check enabled    |
+        +--------------------------*/
+        case M_LL_ID_CHECK:
             *valueP = llHdl->idCheck;
             break;
         /*--------------------------+
@@ -660,10 +1591,15 @@ static int32 M199_GetStat(
     }
 
 	return(error);
-} /* M199_GetStat */
+} /* M199_GetStatCode */
 
 /******************************* M199_BlockRead *******************************/
-/** Read a data block from the device is not supported
+/** Read a data block from the SDRAM
+ *
+ *  The function reads size/2 words from the SDRAM, starting at the
+ *  current block i/o position (see M199_SDRAM_POS). The position is
+ *  advanced by the number of read bytes. At the end of the channel's SDRAM
+ *  area the transfer is truncated.
  *
  *  \param llHdl       \IN  Low-level handle
  *  \param ch          \IN  Current channel
@@ -681,16 +1617,42 @@ static int32 M199_BlockRead(
      int32     *nbrRdBytesP
 )
 {
-    DBGWRT_ERR((DBH, "LL - M199_BlockRead: Not supported\n"));
+	u_int32 nWords = (u_int32)size / 2;
+	u_int32 start = OSS_TickGet(llHdl->osHdl);
+
+    DBGWRT_1((DBH, "LL - M199_BlockRead: ch=%d, size=%d pos=0x%08x\n",
+			  ch, size, llHdl->chPos[ch]));
+
+	LOCK(llHdl,chSemHdl[ch]);
+
+	/* truncate at the end of the channel */
+	if( nWords > (llHdl->chSize[ch] - llHdl->chPos[ch]) / 2 )
+		nWords = (llHdl->chSize[ch] - llHdl->chPos[ch]) / 2;
+
+	SDRAM_LOCK(llHdl);
+	M199_SdramRead(llHdl, llHdl->chBase[ch] + llHdl->chPos[ch], (u_int16*)buf,
+				   nWords, TRUE);
+	SDRAM_UNLOCK(llHdl);
+	llHdl->chPos[ch] += nWords * 2;
+
+	UNLOCK(llHdl,chSemHdl[ch]);
 
 	/* return number of read bytes */
-	*nbrRdBytesP = 0;
+	*nbrRdBytesP = (int32)(nWords * 2);
+
+	llHdl->statBlkRdCalls++;
+	llHdl->statBlkRdTicks += OSS_TickGet(llHdl->osHdl) - start;
 
 	return(ERR_SUCCESS);
 } /* M199_BlockRead */
 
 /****************************** M199_BlockWrite *******************************/
-/** Write a data block from the device is not supported
+/** Write a data block to the SDRAM
+ *
+ *  The function writes size/2 words to the SDRAM, starting at the
+ *  current block i/o position (see M199_SDRAM_POS). The position is
+ *  advanced by the number of written bytes. At the end of the channel's
+ *  SDRAM area the transfer is truncated.
  *
  *  \param llHdl  	   \IN  Low-level handle
  *  \param ch          \IN  Current channel
@@ -708,19 +1670,52 @@ static int32 M199_BlockWrite(
      int32     *nbrWrBytesP
 )
 {
-    DBGWRT_ERR((DBH, "LL - M199_BlockWrite: Not supported\n"));
+	u_int32 nWords = (u_int32)size / 2;
+	u_int32 start = OSS_TickGet(llHdl->osHdl);
+	int32 error = ERR_SUCCESS;
+
+    DBGWRT_1((DBH, "LL - M199_BlockWrite: ch=%d, size=%d pos=0x%08x\n",
+			  ch, size, llHdl->chPos[ch]));
+
+	LOCK(llHdl,chSemHdl[ch]);
+
+	/* truncate at the end of the channel */
+	if( nWords > (llHdl->chSize[ch] - llHdl->chPos[ch]) / 2 )
+		nWords = (llHdl->chSize[ch] - llHdl->chPos[ch]) / 2;
+
+	SDRAM_LOCK(llHdl);
+	M199_SdramWrite(llHdl, llHdl->chBase[ch] + llHdl->chPos[ch], (u_int16*)buf,
+				   nWords, TRUE);
+	SDRAM_UNLOCK(llHdl);
+
+	if( llHdl->chVerify[ch] ){
+		llHdl->chVfyErr[ch] = 0;
+		error = M199_SdramVerify(llHdl, ch, llHdl->chPos[ch], (u_int16*)buf,
+								 nWords);
+	}
+	llHdl->chPos[ch] += nWords * 2;
+
+	UNLOCK(llHdl,chSemHdl[ch]);
 
 	/* return number of written bytes */
-	*nbrWrBytesP = 0;
+	*nbrWrBytesP = (int32)(nWords * 2);
 
-	return(ERR_SUCCESS);
+	llHdl->statBlkWrCalls++;
+	llHdl->statBlkWrTicks += OSS_TickGet(llHdl->osHdl) - start;
+
+	return(error);
 } /* M199_BlockWrite */
 
 
 /****************************** M199_Irq **************************************/
-/** Interrupt service routine is not supported
+/** Interrupt service routine
  *
- *  The interrupt is triggered when ??? occurs.
+ *  The interrupt is triggered when an enabled source of the FPGA user
+ *  cores requests an interrupt in the IRR register.
+ *
+ *  The pending and enabled sources are acknowledged in the IRR, counted
+ *  per source and queued as event with a time stamp. A waiting
+ *  M199_BLK_IRQ_WAIT Getstat is woken up and the installed signal is sent.
  *
  *  If the driver can detect the interrupt's cause it returns
  *  LL_IRQ_DEVICE or LL_IRQ_DEV_NOT, otherwise LL_IRQ_UNKNOWN.
@@ -734,13 +1729,41 @@ static int32 M199_Irq(
    LL_HANDLE *llHdl
 )
 {
-    IDBGWRT_1((DBH, ">>> M199_Irq:\n"));
+	u_int32 irr, n;
+
+	irr = M199_MREAD_D32(llHdl->ma, M199_IRQ_IRR) & llHdl->irqIer;
+	if( irr == 0 )
+		return(LL_IRQ_DEV_NOT);
 
-	/* ... */
+    IDBGWRT_1((DBH, ">>> M199_Irq: irr=0x%08x\n", irr));
+
+	/* acknowledge */
+	M199_MWRITE_D32(llHdl->ma, M199_IRQ_IRR, irr);
 
 	llHdl->irqCount++;
+	for (n=0; n < M199_IRQ_SRC_NUM; n++){
+		if( irr & ((u_int32)1 << n) )
+			llHdl->irqSrcCount[n]++;
+	}
 
-	return(LL_IRQ_DEV_NOT);		/* say: device supports no interrupt */
+	/* queue event */
+	if( llHdl->irqEvNum < IRQ_EVQ_SIZE ){
+		llHdl->irqEvIrr[llHdl->irqEvIn]  = irr;
+		llHdl->irqEvTick[llHdl->irqEvIn] = OSS_TickGet(llHdl->osHdl);
+		llHdl->irqEvIn = (llHdl->irqEvIn + 1) % IRQ_EVQ_SIZE;
+		llHdl->irqEvNum++;
+		OSS_SemSignal(llHdl->osHdl, llHdl->irqSemHdl);
+	}
+	else {
+		IDBGWRT_ERR((DBH, " *** M199_Irq: event queue full\n"));
+		llHdl->irqEvLost++;
+	}
+
+	/* send signal */
+	if( llHdl->sigHdl )
+		OSS_SigSend(llHdl->osHdl, llHdl->sigHdl);
+
+	return(LL_IRQ_DEVICE);
 } /* M199_Irq */
 
 /****************************** M199_Info *************************************/
@@ -864,7 +1887,7 @@ static int32 M199_Info(
 		{
 			u_int32 *lockModeP = va_arg(argptr, u_int32*);
 
-			*lockModeP = LL_LOCK_CALL;
+			*lockModeP = LL_LOCK_NONE;
 			break;
 	    }
 		/*-------------------------------+
@@ -888,25 +1911,2177 @@ static char* M199_Ident( void )
     return( (char*) IdentString );
 } /* M199_Ident*/
 
-/********************************* M199_Cleanup *******************************/
-/** Close all handles, free memory and return error code
+/******************************** M199_MRead16 ********************************/
+/** D16 read of a register (M199_MREAD_D16)
  *
- *	\warning The low-level handle is invalid after this function is called.
+ *  The bus is read once before swapping, OSS_SWAP16() may evaluate its
+ *  argument twice which would advance the autoincrementing data ports twice.
+ *
+ *  \param ma         \IN  HW access handle
+ *  \param offs       \IN  Register offset
+ *
+ *  \return           Register value
+ ******************************************************************************/
+static u_int16 M199_MRead16(
+	MACCESS		ma,
+	u_int32		offs
+)
+{
+	u_int16 val = (u_int16)MREAD_D16(ma, offs);
+
+	return( (u_int16)OSS_SWAP16(val) );
+} /* M199_MRead16 */
+
+#ifdef SDRAM_MREAD32
+/******************************** M199_MRead32 ********************************/
+/** D32 read of the bus, swapped once (see M199_MRead16)
+ *
+ *  \param ma         \IN  HW access handle
+ *  \param offs       \IN  Offset
+ *
+ *  \return           Swapped value
+ ******************************************************************************/
+static u_int32 M199_MRead32(
+	MACCESS		ma,
+	u_int32		offs
+)
+{
+	u_int32 val = (u_int32)MREAD_D32(ma, offs);
+
+	return( (u_int32)OSS_SWAP32(val) );
+} /* M199_MRead32 */
+#endif /* SDRAM_MREAD32 */
+
+/******************************* M199_SdramRead *******************************/
+/** Read words from the SDRAM
+ *
+ *  In A08 mode the SDRAM address register is programmed once, the
+ *  following reads of the data register autoincrement the address.
+ *  In A24 mode the SDRAM is read with D32 accesses, an unaligned head
+ *  and tail word is read with D16.
+ *  The loops only transfer the bus data, if necessary the buffer is byte
+ *  swapped afterwards.
  *
  *  \param llHdl      \IN  Low-level handle
- *  \param retCode    \IN  Return value
+ *  \param offset     \IN  SDRAM offset [bytes]
+ *  \param buf        \OUT Data buffer
+ *  \param nWords     \IN  Number of words to read
+ *  \param setAddr    \IN  A08: program the address register (FALSE: offset
+ *                          continues the previous transfer)
+ ******************************************************************************/
+static void M199_SdramRead(
+	LL_HANDLE	*llHdl,
+	u_int32		offset,
+	u_int16		*buf,
+	u_int32		nWords,
+	int32		setAddr
+)
+{
+	MACCESS ma = llHdl->ma;
+	u_int32 n;
+#ifdef M199_A24
+	u_int16 *dst = buf;
+	u_int32 val, cnt = nWords;
+	u_int16 *valP = (u_int16*)&val;
+#endif /* M199_A24 */
+
+	llHdl->statSdramRd += nWords * 2;
+#ifdef M199_A24
+	/* unaligned head word */
+	if( cnt && (offset & 2) ){
+		*dst++ = SDRAM_RD16(ma, offset);
+		llHdl->statD16Rd++;
+		offset += 2;
+		cnt--;
+	}
+	/* D32 accesses */
+	llHdl->statD32Rd += cnt/2;
+	for (n=0; n < cnt/2; n++){
+		val = SDRAM_RD32(ma, offset + (n*4));
+		dst[n*2]   = valP[0];
+		dst[n*2+1] = valP[1];
+	}
+	/* tail word */
+	if( cnt & 1 ){
+		dst[n*2] = SDRAM_RD16(ma, offset + (n*4));
+		llHdl->statD16Rd++;
+	}
+#else /* M199_A24 */
+	if( setAddr ){
+		llHdl->statSdramAddr++;
+		M199_MWRITE_D32(ma,M199_SDRAM_ADDR,offset);
+	}
+	llHdl->statD16Rd += nWords;
+	for (n=0; n < nWords; n++)
+		buf[n] = SDRAM_RD16(ma, M199_SDRAM_DATA);
+#endif /* M199_A24 */
+
+#ifdef SDRAM_SWAP
+	M199_SwapBuf(buf, nWords);
+#endif
+} /* M199_SdramRead */
+
+/****************************** M199_SdramWrite *******************************/
+/** Write words to the SDRAM
  *
- *  \return           \IN   retCode
+ *  In A08 mode the SDRAM address register is programmed once, the
+ *  following writes to the data register autoincrement the address.
+ *  In A24 mode the SDRAM is written with D32 accesses, an unaligned head
+ *  and tail word is written with D16.
+ *  If the bus order differs from the buffer order, the buffer is byte
+ *  swapped in place before the transfer and restored afterwards, so the
+ *  loops only transfer the bus data.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param offset     \IN  SDRAM offset [bytes]
+ *  \param buf        \IN  Data buffer
+ *  \param nWords     \IN  Number of words to write
+ *  \param setAddr    \IN  A08: program the address register (FALSE: offset
+ *                          continues the previous transfer)
  ******************************************************************************/
-static int32 M199_Cleanup(
-   LL_HANDLE    *llHdl,
-   int32        retCode
+static void M199_SdramWrite(
+	LL_HANDLE	*llHdl,
+	u_int32		offset,
+	u_int16		*buf,
+	u_int32		nWords,
+	int32		setAddr
 )
 {
-	DBGWRT_1(( DBH, " Cleanup (M199) \n"));
-    /*------------------------------+
-    |  close handles                |
-    +------------------------------*/
+	MACCESS ma = llHdl->ma;
+	u_int32 n;
+#ifdef M199_A24
+	u_int16 *src = buf;
+	u_int32 val, cnt = nWords;
+	u_int16 *valP = (u_int16*)&val;
+#endif /* M199_A24 */
+
+	llHdl->statSdramWr += nWords * 2;
+#ifdef SDRAM_SWAP
+	M199_SwapBuf(buf, nWords);
+#endif
+
+#ifdef M199_A24
+	/* unaligned head word */
+	if( cnt && (offset & 2) ){
+		SDRAM_WR16(ma, offset, *src);
+		llHdl->statD16Wr++;
+		src++;
+		offset += 2;
+		cnt--;
+	}
+	/* D32 accesses */
+	llHdl->statD32Wr += cnt/2;
+	for (n=0; n < cnt/2; n++){
+		valP[0] = src[n*2];
+		valP[1] = src[n*2+1];
+		SDRAM_WR32(ma, offset + (n*4), val);
+	}
+	/* tail word */
+	if( cnt & 1 ){
+		SDRAM_WR16(ma, offset + (n*4), src[n*2]);
+		llHdl->statD16Wr++;
+	}
+#else /* M199_A24 */
+	if( setAddr ){
+		llHdl->statSdramAddr++;
+		M199_MWRITE_D32(ma,M199_SDRAM_ADDR,offset);
+	}
+	llHdl->statD16Wr += nWords;
+	for (n=0; n < nWords; n++)
+		SDRAM_WR16(ma, M199_SDRAM_DATA, buf[n]);
+#endif /* M199_A24 */
+
+#ifdef SDRAM_SWAP
+	M199_SwapBuf(buf, nWords);
+#endif
+} /* M199_SdramWrite */
+
+#ifdef SDRAM_SWAP
+/******************************** M199_SwapBuf ********************************/
+/** Swap the bytes of all words of a buffer
+ *
+ *  The words are swapped in pairs with 32-bit operations.
+ *
+ *  \param buf        \IN  Buffer
+ *                    \OUT Swapped buffer
+ *  \param nWords     \IN  Number of words
+ ******************************************************************************/
+static void M199_SwapBuf(
+	u_int16		*buf,
+	u_int32		nWords
+)
+{
+	u_int32 *p, n, val;
+
+	/* unaligned head word */
+	if( nWords && ((U_INT32_OR_64)buf & 2) ){
+		*buf = (u_int16)OSS_SWAP16(*buf);
+		buf++;
+		nWords--;
+	}
+	p = (u_int32*)buf;
+	for (n=0; n < nWords/2; n++){
+		val  = p[n];
+		p[n] = ((val & 0x00ff00ff) << 8) | ((val >> 8) & 0x00ff00ff);
+	}
+	/* tail word */
+	if( nWords & 1 )
+		buf[nWords-1] = (u_int16)OSS_SWAP16(buf[nWords-1]);
+} /* M199_SwapBuf */
+#endif /* SDRAM_SWAP */
+
+/******************************** M199_SdramSg ********************************/
+/** Read or write a list of SDRAM segments (M199_BLK_SDRAM_SG)
+ *
+ *  The segment data follows the segment list in the block (see
+ *  M199_SDRAM_SG_DATA). The segment offsets are relative to the channel's
+ *  SDRAM area. In A08 mode the address register is only programmed if a
+ *  segment does not continue the previous one.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param blk        \IN  Block with M199_SDRAM_SG structure
+ *  \param write      \IN  TRUE: write segments, FALSE: read segments
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_SdramSg(
+	LL_HANDLE	*llHdl,
+	int32		ch,
+	M_SG_BLOCK	*blk,
+	int32		write
+)
+{
+	M199_SDRAM_SG *sg = (M199_SDRAM_SG*)blk->data;
+	M199_SDRAM_SEG *seg;
+	u_int16 *dataP;
+	u_int32 n, left, next = 0;
+	int32 error = ERR_SUCCESS;
+
+	/* check segment list and data size */
+	if( (u_int32)blk->size < M199_SDRAM_SG_HDRSIZE(0) ||
+		sg->segNum > ((u_int32)blk->size - M199_SDRAM_SG_HDRSIZE(0)) /
+		sizeof(M199_SDRAM_SEG) ){
+		DBGWRT_ERR(( DBH, " *** M199_SdramSg: Block size too small\n"));
+		return(ERR_LL_USERBUF);
+	}
+	/* data bytes left in the block, each segment must fit the rest */
+	left = (u_int32)blk->size - M199_SDRAM_SG_HDRSIZE(sg->segNum);
+	for (n=0; n < sg->segNum; n++){
+		seg = &sg->seg[n];
+		if( (seg->offset & 1) || (seg->size & 1) ||
+			seg->offset > llHdl->chSize[ch] ||
+			seg->size > llHdl->chSize[ch] - seg->offset ){
+			DBGWRT_ERR(( DBH, " *** M199_SdramSg: illegal segment %d "
+						 "offset=0x%08x size=0x%x\n", n, seg->offset, seg->size));
+			return(ERR_LL_ILL_PARAM);
+		}
+		if( seg->size > left ){
+			DBGWRT_ERR(( DBH, " *** M199_SdramSg: Block size too small\n"));
+			return(ERR_LL_USERBUF);
+		}
+		left -= seg->size;
+	}
+
+	/* transfer segments */
+	dataP = M199_SDRAM_SG_DATA(sg);
+	SDRAM_LOCK(llHdl);
+	for (n=0; n < sg->segNum; n++){
+		seg = &sg->seg[n];
+		if( write )
+			M199_SdramWrite(llHdl, llHdl->chBase[ch] + seg->offset, dataP,
+							seg->size/2, (n == 0 || seg->offset != next));
+		else
+			M199_SdramRead(llHdl, llHdl->chBase[ch] + seg->offset, dataP,
+						   seg->size/2, (n == 0 || seg->offset != next));
+		next   = seg->offset + seg->size;
+		dataP += seg->size/2;
+	}
+	SDRAM_UNLOCK(llHdl);
+
+	/* verify all segments */
+	if( write && llHdl->chVerify[ch] ){
+		llHdl->chVfyErr[ch] = 0;
+		dataP = M199_SDRAM_SG_DATA(sg);
+		for (n=0; n < sg->segNum; n++){
+			seg = &sg->seg[n];
+			/* mismatches accumulate, ERR_LL_WRITE if any so far */
+			error = M199_SdramVerify(llHdl, ch, seg->offset, dataP,
+									 seg->size/2);
+			if( error == ERR_OSS_MEM_ALLOC )
+				break;
+			dataP += seg->size/2;
+		}
+	}
+
+	return(error);
+} /* M199_SdramSg */
+
+/****************************** M199_SdramVerify ******************************/
+/** Verify written SDRAM data
+ *
+ *  Reads the data back in blocks of SDRAM_BUF_WORDS and compares it with
+ *  the written buffer. The mismatches are added to the channel's
+ *  verification result, which the caller resets before the first call of
+ *  a write request.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param offset     \IN  Offset in the channel's SDRAM area [bytes]
+ *  \param buf        \IN  Written data
+ *  \param nWords     \IN  Number of words
+ *
+ *  \return           \c 0 On success, ERR_LL_WRITE on mismatch or error code
+ ******************************************************************************/
+static int32 M199_SdramVerify(
+	LL_HANDLE	*llHdl,
+	int32		ch,
+	u_int32		offset,
+	u_int16		*buf,
+	u_int32		nWords
+)
+{
+	u_int32 n, i, chunk, gotsize;
+	u_int16 *rd;
+
+	rd = (u_int16*)OSS_MemGet(llHdl->osHdl, SDRAM_BUF_WORDS * 2, &gotsize);
+	if( rd == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+
+	for (n=0; n < nWords; n += chunk){
+		chunk = (nWords - n < SDRAM_BUF_WORDS) ?
+			nWords - n : SDRAM_BUF_WORDS;
+		SDRAM_LOCK(llHdl);
+		M199_SdramRead(llHdl, llHdl->chBase[ch] + offset + n*2, rd, chunk,
+					   TRUE);
+		SDRAM_UNLOCK(llHdl);
+
+		for (i=0; i < chunk; i++){
+			if( rd[i] == buf[n + i] )
+				continue;
+			if( llHdl->chVfyErr[ch]++ == 0 )
+				llHdl->chVfyOffs[ch] = offset + (n + i) * 2;
+		}
+	}
+	OSS_MemFree(llHdl->osHdl, (int8*)rd, gotsize);
+
+	if( llHdl->chVfyErr[ch] ){
+		DBGWRT_ERR(( DBH, " *** M199_SdramVerify: %d mismatch(es), first at "
+					 "0x%08x\n", llHdl->chVfyErr[ch], llHdl->chVfyOffs[ch]));
+		return(ERR_LL_WRITE);
+	}
+	return(ERR_SUCCESS);
+} /* M199_SdramVerify */
+
+/******************************* M199_SdramFill *******************************/
+/** Fill an SDRAM area with a pattern (M199_BLK_SDRAM_FILL)
+ *
+ *  The pattern words are converted to the bus order once, the loops only
+ *  write them. In A24 mode the area is written with D32 accesses. In A08
+ *  mode the area is filled in blocks of SDRAM_BUF_WORDS, the SDRAM port is
+ *  released between the blocks.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param offset     \IN  SDRAM offset [bytes]
+ *  \param pat        \IN  Pattern words for even and odd word index
+ *  \param nWords     \IN  Number of words to write
+ ******************************************************************************/
+static void M199_SdramFill(
+	LL_HANDLE	*llHdl,
+	u_int32		offset,
+	u_int16		*pat,
+	u_int32		nWords
+)
+{
+	MACCESS ma = llHdl->ma;
+	u_int32 n, cnt, chunk;
+	u_int16 w[2];
+#ifdef M199_A24
+	u_int32 val, hval, v, o;
+	u_int16 first;
+	u_int16 *valP = (u_int16*)&val;
+	u_int16 *hvalP = (u_int16*)&hval;
+#endif /* M199_A24 */
+
+	w[0] = pat[0];
+	w[1] = pat[1];
+#ifdef SDRAM_SWAP
+	M199_SwapBuf(w, 2);
+#endif
+
+#ifdef M199_A24
+	/* D32 values for an aligned and an unaligned start */
+	valP[0]  = w[0];
+	valP[1]  = w[1];
+	hvalP[0] = w[1];
+	hvalP[1] = w[0];
+#endif /* M199_A24 */
+
+	llHdl->statSdramWr += nWords * 2;
+	/* even block size keeps the pattern phase */
+	for ( ; nWords; nWords -= chunk, offset += chunk * 2){
+#ifdef M199_A24
+		chunk = nWords;			/* no port to release */
+#else
+		chunk = nWords < SDRAM_BUF_WORDS ? nWords : SDRAM_BUF_WORDS;
+#endif
+		cnt = chunk;
+
+		SDRAM_LOCK(llHdl);
+#ifdef M199_A24
+		o     = offset;
+		v     = val;
+		first = w[0];
+		/* unaligned head word, the rest starts with w[1] */
+		if( o & 2 ){
+			SDRAM_WR16(ma, o, w[0]);
+			llHdl->statD16Wr++;
+			o += 2;
+			cnt--;
+			v     = hval;
+			first = w[1];
+		}
+		/* D32 accesses */
+		llHdl->statD32Wr += cnt/2;
+		for (n=0; n < cnt/2; n++)
+			SDRAM_WR32(ma, o + (n*4), v);
+		/* tail word */
+		if( cnt & 1 ){
+			SDRAM_WR16(ma, o + (n*4), first);
+			llHdl->statD16Wr++;
+		}
+#else /* M199_A24 */
+		llHdl->statSdramAddr++;
+		M199_MWRITE_D32(ma,M199_SDRAM_ADDR,offset);
+		llHdl->statD16Wr += cnt;
+		for (n=0; n < cnt/2; n++){
+			SDRAM_WR16(ma, M199_SDRAM_DATA, w[0]);
+			SDRAM_WR16(ma, M199_SDRAM_DATA, w[1]);
+		}
+		if( cnt & 1 )
+			SDRAM_WR16(ma, M199_SDRAM_DATA, w[0]);
+#endif /* M199_A24 */
+		SDRAM_UNLOCK(llHdl);
+	}
+} /* M199_SdramFill */
+
+/******************************* M199_SdramCopy *******************************/
+/** Copy an SDRAM area to another (M199_BLK_SDRAM_COPY)
+ *
+ *  The areas may overlap, if the destination is above the source the area
+ *  is copied from its end. The data is copied in bus order without
+ *  swapping.
+ *  In A08 mode the area is copied in blocks of SDRAM_BUF_WORDS, each block
+ *  is read through the autoincrementing data register into a driver buffer
+ *  and written back the same way. The SDRAM port is released between the
+ *  blocks. In A24
+ *  mode the window is copied directly with D32 accesses if source and
+ *  destination have the same alignment, otherwise with D16 accesses.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param dst        \IN  Destination SDRAM offset [bytes]
+ *  \param src        \IN  Source SDRAM offset [bytes]
+ *  \param nWords     \IN  Number of words to copy
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_SdramCopy(
+	LL_HANDLE	*llHdl,
+	u_int32		dst,
+	u_int32		src,
+	u_int32		nWords
+)
+{
+	MACCESS ma = llHdl->ma;
+	int32 down = (dst > src);
+	u_int32 done, chunk, n, s, d, k;
+#ifdef M199_A24
+	u_int32 head, pairs, tail;
+#else
+	u_int16 *buf;
+	u_int32 gotsize;
+
+	buf = (u_int16*)OSS_MemGet(llHdl->osHdl, SDRAM_BUF_WORDS * 2, &gotsize);
+	if( buf == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+#endif /* M199_A24 */
+
+	if( dst == src )
+		nWords = 0;
+	llHdl->statSdramRd += nWords * 2;
+	llHdl->statSdramWr += nWords * 2;
+
+	for (done=0; done < nWords; done += chunk){
+#ifdef M199_A24
+		chunk = nWords;			/* no port to release */
+#else
+		chunk = nWords - done < SDRAM_BUF_WORDS ?
+			nWords - done : SDRAM_BUF_WORDS;
+#endif
+		n = down ? nWords - done - chunk : done;
+		s = src + n*2;
+		d = dst + n*2;
+
+		SDRAM_LOCK(llHdl);
+#ifdef M199_A24
+		head  = 0;
+		pairs = 0;
+		tail  = chunk;
+		if( !((s ^ d) & 2) ){
+			head  = (s & 2) ? 1 : 0;
+			pairs = (chunk - head) / 2;
+			tail  = (chunk - head) & 1;
+		}
+		llHdl->statD16Rd += head + tail;
+		llHdl->statD16Wr += head + tail;
+		llHdl->statD32Rd += pairs;
+		llHdl->statD32Wr += pairs;
+
+		if( !down ){
+			if( head )
+				SDRAM_WR16(ma, d, SDRAM_RD16(ma, s));
+			for (k=0; k < pairs; k++)
+				SDRAM_WR32(ma, d + head*2 + k*4,
+						   SDRAM_RD32(ma, s + head*2 + k*4));
+			for (k=0; k < tail; k++)
+				SDRAM_WR16(ma, d + (head + pairs*2 + k)*2,
+						   SDRAM_RD16(ma, s + (head + pairs*2 + k)*2));
+		}
+		else {
+			for (k=tail; k > 0; k--)
+				SDRAM_WR16(ma, d + (head + pairs*2 + k-1)*2,
+						   SDRAM_RD16(ma, s + (head + pairs*2 + k-1)*2));
+			for (k=pairs; k > 0; k--)
+				SDRAM_WR32(ma, d + head*2 + (k-1)*4,
+						   SDRAM_RD32(ma, s + head*2 + (k-1)*4));
+			if( head )
+				SDRAM_WR16(ma, d, SDRAM_RD16(ma, s));
+		}
+#else /* M199_A24 */
+		llHdl->statSdramAddr += 2;
+		llHdl->statD16Rd += chunk;
+		llHdl->statD16Wr += chunk;
+		M199_MWRITE_D32(ma,M199_SDRAM_ADDR,s);
+		for (k=0; k < chunk; k++)
+			buf[k] = SDRAM_RD16(ma, M199_SDRAM_DATA);
+		M199_MWRITE_D32(ma,M199_SDRAM_ADDR,d);
+		for (k=0; k < chunk; k++)
+			SDRAM_WR16(ma, M199_SDRAM_DATA, buf[k]);
+#endif /* M199_A24 */
+		SDRAM_UNLOCK(llHdl);
+	}
+
+#ifndef M199_A24
+	OSS_MemFree(llHdl->osHdl, (int8*)buf, gotsize);
+#endif
+	return(ERR_SUCCESS);
+} /* M199_SdramCopy */
+
+/******************************* M199_SdramTest *******************************/
+/** SDRAM memory test (M199_BLK_SDRAM_TEST)
+ *
+ *  Each selected test writes its pattern to the whole range and reads it
+ *  back in blocks of SDRAM_BUF_WORDS. The patterns depend on the SDRAM word
+ *  address, so the address-in-address test detects aliasing of all
+ *  address lines. The SDRAM port is released between the blocks, so other
+ *  channels are not blocked in A08 mode.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param t          \IN  Range and tests
+ *                    \OUT Failure report
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_SdramTest(
+	LL_HANDLE		*llHdl,
+	int32			ch,
+	M199_SDRAM_TEST	*t
+)
+{
+	u_int32 base = llHdl->chBase[ch] + t->offset;
+	u_int32 nWords = t->size / 2;
+	u_int32 test, pass, passNum, n, i, chunk, rnd, gotsize, start;
+	u_int16 *buf, expect;
+
+	buf = (u_int16*)OSS_MemGet(llHdl->osHdl, SDRAM_BUF_WORDS * 2, &gotsize);
+	if( buf == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+
+	start = OSS_TickGet(llHdl->osHdl);
+	t->errCount = 0;
+	t->errTests = 0;
+
+	for (test = M199_SDRAM_TEST_WALK1; test <= M199_SDRAM_TEST_RANDOM;
+		 test <<= 1){
+		if( !(t->tests & test) )
+			continue;
+		passNum = (test == M199_SDRAM_TEST_ADDR ||
+				   test == M199_SDRAM_TEST_CHECKER) ? 2 : 1;
+
+		for (pass=0; pass < passNum; pass++){
+			/* write pattern */
+			rnd = t->seed;
+			for (n=0; n < nWords; n += chunk){
+				chunk = (nWords - n < SDRAM_BUF_WORDS) ?
+					nWords - n : SDRAM_BUF_WORDS;
+				for (i=0; i < chunk; i++)
+					buf[i] = M199_TestWord(test, pass, base/2 + n + i, &rnd);
+				SDRAM_LOCK(llHdl);
+				M199_SdramWrite(llHdl, base + n*2, buf, chunk, TRUE);
+				SDRAM_UNLOCK(llHdl);
+			}
+
+			/* verify */
+			rnd = t->seed;
+			for (n=0; n < nWords; n += chunk){
+				chunk = (nWords - n < SDRAM_BUF_WORDS) ?
+					nWords - n : SDRAM_BUF_WORDS;
+				SDRAM_LOCK(llHdl);
+				M199_SdramRead(llHdl, base + n*2, buf, chunk, TRUE);
+				SDRAM_UNLOCK(llHdl);
+				for (i=0; i < chunk; i++){
+					expect = M199_TestWord(test, pass, base/2 + n + i, &rnd);
+					if( buf[i] == expect )
+						continue;
+					if( t->errCount < M199_SDRAM_ERR_NUM ){
+						t->err[t->errCount].offset = t->offset + (n + i) * 2;
+						t->err[t->errCount].expect = expect;
+						t->err[t->errCount].actual = buf[i];
+						t->err[t->errCount].test   = test;
+					}
+					t->errCount++;
+					t->errTests |= test;
+					if( t->maxErr && t->errCount >= t->maxErr )
+						goto done;
+				}
+			}
+		}
+	}
+
+done:
+	t->ticks    = OSS_TickGet(llHdl->osHdl) - start;
+	t->tickRate = OSS_TickRateGet(llHdl->osHdl);
+	OSS_MemFree(llHdl->osHdl, (int8*)buf, gotsize);
+
+	DBGWRT_2((DBH, " M199_SdramTest: tests=0x%x errors=%d\n",
+			  t->tests, t->errCount));
+	return(ERR_SUCCESS);
+} /* M199_SdramTest */
+
+/****************************** M199_SdramCheck *******************************/
+/** Checksum, CRC and min/max of an SDRAM area (M199_BLK_SDRAM_CHECK)
+ *
+ *  The area is read in blocks of SDRAM_BUF_WORDS into a driver buffer,
+ *  only the results are returned. The sum is accumulated per block in 32
+ *  bits and added to the 64-bit result with carry.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param chk        \IN  Range and flags
+ *                    \OUT Results
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_SdramCheck(
+	LL_HANDLE			*llHdl,
+	int32				ch,
+	M199_SDRAM_CHECK	*chk
+)
+{
+	u_int32 base = llHdl->chBase[ch] + chk->offset;
+	u_int32 nWords = chk->size / 2;
+	int32 sgn = (chk->flags & M199_SDRAM_CHECK_SIGNED) ? TRUE : FALSE;
+	u_int32 n, i, chunk, gotsize, sum, crc = 0xffffffff;
+	u_int8 *p;
+	int32 val;
+	u_int16 *buf;
+
+	buf = (u_int16*)OSS_MemGet(llHdl->osHdl, SDRAM_BUF_WORDS * 2, &gotsize);
+	if( buf == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+
+	chk->sumLo = 0;
+	chk->sumHi = 0;
+	chk->min   = 0;
+	chk->max   = 0;
+
+	for (n=0; n < nWords; n += chunk){
+		chunk = (nWords - n < SDRAM_BUF_WORDS) ?
+			nWords - n : SDRAM_BUF_WORDS;
+		SDRAM_LOCK(llHdl);
+		M199_SdramRead(llHdl, base + n*2, buf, chunk, TRUE);
+		SDRAM_UNLOCK(llHdl);
+
+		if( n == 0 )
+			chk->min = chk->max = sgn ? (int32)(int16)buf[0] : (int32)buf[0];
+
+		/* block sum fits in 32 bits: SDRAM_BUF_WORDS * 0xffff */
+		sum = 0;
+		for (i=0; i < chunk; i++){
+			val = sgn ? (int32)(int16)buf[i] : (int32)buf[i];
+			sum += (u_int32)val;
+			if( val < chk->min )
+				chk->min = val;
+			if( val > chk->max )
+				chk->max = val;
+		}
+		chk->sumLo += sum;
+		if( chk->sumLo < sum )
+			chk->sumHi++;
+		if( sgn && (int32)sum < 0 )
+			chk->sumHi--;
+
+		if( chk->flags & M199_SDRAM_CHECK_CRC ){
+			p = (u_int8*)buf;
+			for (i=0; i < chunk*2; i++){
+				crc ^= p[i];
+				crc = (crc >> 4) ^ G_crcTab[crc & 0xf];
+				crc = (crc >> 4) ^ G_crcTab[crc & 0xf];
+			}
+		}
+	}
+	chk->crc = (chk->flags & M199_SDRAM_CHECK_CRC) ? ~crc : 0;
+
+	OSS_MemFree(llHdl->osHdl, (int8*)buf, gotsize);
+	return(ERR_SUCCESS);
+} /* M199_SdramCheck */
+
+/****************************** M199_SdramFind ********************************/
+/** Search a value in an SDRAM area (M199_BLK_SDRAM_FIND)
+ *
+ *  The area is read in blocks of SDRAM_BUF_WORDS into a driver buffer
+ *  until the first match.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param find       \IN  Range, value and mask
+ *                    \OUT Offset of the first match
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_SdramFind(
+	LL_HANDLE			*llHdl,
+	int32				ch,
+	M199_SDRAM_FIND		*find
+)
+{
+	u_int32 base = llHdl->chBase[ch] + find->offset;
+	u_int32 nWords = find->size / 2;
+	u_int16 mask = find->mask, value = find->value & find->mask;
+	u_int32 n, i, chunk, gotsize;
+	u_int16 *buf;
+
+	buf = (u_int16*)OSS_MemGet(llHdl->osHdl, SDRAM_BUF_WORDS * 2, &gotsize);
+	if( buf == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+
+	find->found       = FALSE;
+	find->foundOffset = 0;
+	for (n=0; n < nWords && !find->found; n += chunk){
+		chunk = (nWords - n < SDRAM_BUF_WORDS) ?
+			nWords - n : SDRAM_BUF_WORDS;
+		SDRAM_LOCK(llHdl);
+		M199_SdramRead(llHdl, base + n*2, buf, chunk, TRUE);
+		SDRAM_UNLOCK(llHdl);
+
+		for (i=0; i < chunk; i++){
+			if( (buf[i] & mask) == value ){
+				find->found       = TRUE;
+				find->foundOffset = find->offset + (n + i) * 2;
+				break;
+			}
+		}
+	}
+
+	OSS_MemFree(llHdl->osHdl, (int8*)buf, gotsize);
+	return(ERR_SUCCESS);
+} /* M199_SdramFind */
+
+/******************************* M199_TestWord ********************************/
+/** Pattern word of the SDRAM memory test
+ *
+ *  \param test       \IN  M199_SDRAM_TEST_xxx (one test)
+ *  \param pass       \IN  Pass of the test
+ *  \param idx        \IN  SDRAM word address
+ *  \param rndP       \IN  Random generator state
+ *                    \OUT Next state
+ *
+ *  \return           Pattern word
+ ******************************************************************************/
+static u_int16 M199_TestWord(
+	u_int32		test,
+	u_int32		pass,
+	u_int32		idx,
+	u_int32		*rndP
+)
+{
+	switch(test) {
+		case M199_SDRAM_TEST_WALK1:
+			return( (u_int16)(1 << (idx & 15)) );
+		case M199_SDRAM_TEST_WALK0:
+			return( (u_int16)~(1 << (idx & 15)) );
+		case M199_SDRAM_TEST_ADDR:
+			/* word address bits 0..15, then bits 8..23 */
+			return( (u_int16)(pass ? (idx >> 8) : idx) );
+		case M199_SDRAM_TEST_CHECKER:
+			return( ((idx ^ pass) & 1) ? 0xaaaa : 0x5555 );
+		default:
+			/* linear congruential generator */
+			*rndP = *rndP * 1103515245 + 12345;
+			return( (u_int16)(*rndP >> 16) );
+	}
+} /* M199_TestWord */
+
+/****************************** M199_AsyncSubmit ******************************/
+/** Queue an asynchronous SDRAM transfer (M199_BLK_ASYNC_SUBMIT)
+ *
+ *  The request and its data are copied into a driver buffer and executed
+ *  by M199_AsyncWork(). The call returns at once. A write is verified if
+ *  the channel verifies writes (M199_SDRAM_VERIFY) when it is submitted.
+ *
+ *  If the queue is full, the oldest completed request that nobody waits
+ *  for is dropped. If all requests are in progress or waited for, the
+ *  submit fails with ERR_LL_DEV_BUSY.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param blk        \IN  M199_ASYNC_REQ block
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_AsyncSubmit(
+	LL_HANDLE	*llHdl,
+	int32		ch,
+	M_SG_BLOCK	*blk
+)
+{
+	M199_ASYNC_REQ *ar = (M199_ASYNC_REQ*)blk->data;
+	ASYNC_REQ *req, *drop = NULL, **lastP;
+	u_int32 gotsize, verify;
+	int32 error, start = FALSE;
+
+	if( blk->size < M199_ASYNC_REQ_MINSIZE ||
+		((ar->flags & M199_ASYNC_WRITE) &&
+		 (u_int32)blk->size - M199_ASYNC_REQ_MINSIZE < ar->size) ){
+		DBGWRT_ERR(( DBH, " *** M199_AsyncSubmit: Block size too small\n"));
+		return(ERR_LL_USERBUF);
+	}
+	if( (ar->offset & 1) || (ar->size & 1) ||
+		ar->offset > llHdl->chSize[ch] ||
+		ar->size > llHdl->chSize[ch] - ar->offset ){
+		DBGWRT_ERR(( DBH, " *** M199_AsyncSubmit: illegal SDRAM range\n"));
+		return(ERR_LL_ILL_PARAM);
+	}
+	verify = (ar->flags & M199_ASYNC_WRITE) && llHdl->chVerify[ch];
+
+	req = (ASYNC_REQ*)OSS_MemGet(llHdl->osHdl, sizeof(ASYNC_REQ) + ar->size +
+								 (verify ? ASYNC_CHUNK * 2 : 0), &gotsize);
+	if( req == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+	OSS_MemFill(llHdl->osHdl, sizeof(ASYNC_REQ), (char*)req, 0x00);
+	req->gotsize = gotsize;
+	req->ch      = ch;
+	req->tag     = ar->tag;
+	req->flags   = ar->flags;
+	req->offset  = ar->offset;
+	req->size    = ar->size;
+	req->queued  = TRUE;
+	req->verify  = verify;
+	error = OSS_SemCreate(llHdl->osHdl, OSS_SEM_BIN, 0, &req->doneSemHdl);
+	if( error ){
+		M199_AsyncFree(llHdl, req);
+		return(error);
+	}
+	if( ar->flags & M199_ASYNC_WRITE )
+		OSS_MemCopy(llHdl->osHdl, ar->size, (char*)ar->buf,
+					(char*)ASYNC_DATA(req));
+
+	/* append, drop a completion nobody waits for if full */
+	OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+	if( llHdl->asyncNum >= M199_ASYNC_MAX ){
+		for (lastP = &llHdl->asyncList; *lastP; lastP = &(*lastP)->next){
+			if( !(*lastP)->queued && !(*lastP)->waiting ){
+				drop   = *lastP;
+				*lastP = drop->next;
+				llHdl->asyncNum--;
+				break;
+			}
+		}
+	}
+	if( llHdl->asyncNum >= M199_ASYNC_MAX ){
+		OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+		DBGWRT_ERR(( DBH, " *** M199_AsyncSubmit: too many requests\n"));
+		M199_AsyncFree(llHdl, req);
+		return(ERR_LL_DEV_BUSY);
+	}
+	for (lastP = &llHdl->asyncList; *lastP; lastP = &(*lastP)->next)
+		;
+	*lastP = req;
+	llHdl->asyncNum++;
+	if( !llHdl->asyncRun )
+		start = llHdl->asyncRun = TRUE;
+	OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+
+	if( drop ){
+		DBGWRT_2(( DBH, " M199_AsyncSubmit: dropped completed tag 0x%x\n",
+				   drop->tag));
+		M199_AsyncFree(llHdl, drop);
+	}
+
+	/* start the worker if idle, the requests fail if it can't run */
+	if( start ){
+		error = OSS_TimerStart(llHdl->osHdl, llHdl->asyncTimHdl, ASYNC_DELAY,
+							   FALSE);
+		if( error ){
+			DBGWRT_ERR(( DBH, " *** M199_AsyncSubmit: can't start worker\n"));
+			M199_AsyncAbort(llHdl, error);
+		}
+	}
+
+	return(ERR_SUCCESS);
+} /* M199_AsyncSubmit */
+
+/******************************* M199_AsyncWait *******************************/
+/** Wait for an asynchronous SDRAM transfer (M199_BLK_ASYNC_WAIT)
+ *
+ *  The requests of a channel complete in submit order. A completed request
+ *  is removed, the data of a read request are returned in the block. On a
+ *  timeout the request remains queued.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param blk        \IN  M199_ASYNC_DONE block
+ *                    \OUT Transfer result and read data
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_AsyncWait(
+	LL_HANDLE	*llHdl,
+	int32		ch,
+	M_SG_BLOCK	*blk
+)
+{
+	M199_ASYNC_DONE *done = (M199_ASYNC_DONE*)blk->data;
+	ASYNC_REQ *req, **prevP;
+	int32 error = ERR_SUCCESS;
+	int32 timeout;
+
+	if( blk->size < M199_ASYNC_DONE_MINSIZE ){
+		DBGWRT_ERR(( DBH, " *** M199_AsyncWait: Block size too small\n"));
+		return(ERR_LL_USERBUF);
+	}
+	timeout = (done->timeout < 0) ? OSS_SEM_WAITFOREVER :
+			  (done->timeout == 0) ? OSS_SEM_NOWAIT : done->timeout;
+
+	/* find the request and reserve it for this caller */
+	OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+	for (req = llHdl->asyncList; req; req = req->next){
+		if( req->ch != ch )
+			continue;
+		if( done->tag == M199_ASYNC_ANY ? !req->waiting : req->tag == done->tag )
+			break;
+	}
+	if( req == NULL )
+		error = ERR_LL_ILL_PARAM;
+	else if( req->waiting )
+		error = ERR_LL_DEV_BUSY;
+	else if( !(req->flags & M199_ASYNC_WRITE) &&
+			 (u_int32)blk->size - M199_ASYNC_DONE_MINSIZE < req->size )
+		error = ERR_LL_USERBUF;
+	else
+		req->waiting = TRUE;
+	OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+	if( error ){
+		DBGWRT_ERR(( DBH, " *** M199_AsyncWait: tag 0x%x error 0x%x\n",
+					 done->tag, error));
+		return(error);
+	}
+
+	error = OSS_SemWait(llHdl->osHdl, req->doneSemHdl, timeout);
+	OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+	if( error ){
+		req->waiting = FALSE;
+		OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+		return(error);
+	}
+	for (prevP = &llHdl->asyncList; *prevP != req; prevP = &(*prevP)->next)
+		;
+	*prevP = req->next;
+	llHdl->asyncNum--;
+	OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+
+	done->tag    = req->tag;
+	done->error  = req->error;
+	done->flags  = req->flags;
+	done->offset = req->offset;
+	done->size   = req->size;
+	if( !(req->flags & M199_ASYNC_WRITE) )
+		OSS_MemCopy(llHdl->osHdl, req->size, (char*)ASYNC_DATA(req),
+					(char*)done->buf);
+	M199_AsyncFree(llHdl, req);
+
+	return(ERR_SUCCESS);
+} /* M199_AsyncWait */
+
+/******************************* M199_AsyncWork *******************************/
+/** Worker of the asynchronous SDRAM transfers (timer callback)
+ *
+ *  Executes the queued requests in submit order, ASYNC_CHUNK words at a
+ *  time. The channel and the SDRAM port are locked per chunk only, so
+ *  synchronous calls are delayed by one chunk at most. The run ends after
+ *  about ASYNC_RUN_MAX ms and restarts the timer for the rest, so the
+ *  callback never holds the CPU for long. It must not block: if the
+ *  channel or the SDRAM port is locked by a caller, the timer is
+ *  restarted and the chunk is retried later. A verified write reads each
+ *  chunk back, the request fails with ERR_LL_WRITE on a mismatch and sets
+ *  the channel's verification result like a synchronous write. When the
+ *  device is closed (asyncStop), the worker ends without a restart.
+ *
+ *  \param arg        \IN  Low-level handle
+ ******************************************************************************/
+static void M199_AsyncWork(
+	void	*arg
+)
+{
+	LL_HANDLE *llHdl = (LL_HANDLE*)arg;
+	ASYNC_REQ *req;
+	u_int16 *data, *vfy;
+	u_int32 n, nWords, offset, start, ticks;
+	int32 error, delay, complete;
+
+	start = OSS_TickGet(llHdl->osHdl);
+	ticks = (ASYNC_RUN_MAX * OSS_TickRateGet(llHdl->osHdl)) / 1000;
+
+	for (;;) {
+		/* oldest request not completed, stop if none or closing */
+		OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+		for (req = llHdl->asyncList; req && !req->queued; req = req->next)
+			;
+		if( llHdl->asyncStop )
+			req = NULL;
+		llHdl->asyncBusy = (req != NULL);
+		if( req == NULL )
+			llHdl->asyncRun = FALSE;
+		OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+		if( req == NULL )
+			return;
+
+		/* run time used up: continue later */
+		if( OSS_TickGet(llHdl->osHdl) - start > ticks ){
+			delay = ASYNC_DELAY;
+			break;
+		}
+
+		/* locked by a caller: retry */
+		delay = ASYNC_RETRY;
+		if( OSS_SemWait(llHdl->osHdl, llHdl->chSemHdl[req->ch],
+						OSS_SEM_NOWAIT) )
+			break;
+#ifndef M199_A24
+		if( OSS_SemWait(llHdl->osHdl, llHdl->sdramSemHdl, OSS_SEM_NOWAIT) ){
+			UNLOCK(llHdl,chSemHdl[req->ch]);
+			break;
+		}
+#endif
+
+		/* next chunk */
+		nWords = (req->size - req->done) / 2;
+		if( nWords > ASYNC_CHUNK )
+			nWords = ASYNC_CHUNK;
+		offset = llHdl->chBase[req->ch] + req->offset + req->done;
+		data   = ASYNC_DATA(req) + req->done / 2;
+		if( req->flags & M199_ASYNC_WRITE ){
+			M199_SdramWrite(llHdl, offset, data, nWords, TRUE);
+			if( req->verify ){
+				vfy = ASYNC_VFY(req);
+				M199_SdramRead(llHdl, offset, vfy, nWords, TRUE);
+				for (n=0; n < nWords; n++){
+					if( vfy[n] != data[n] && req->vfyErr++ == 0 )
+						req->vfyOffs = req->offset + req->done + n*2;
+				}
+			}
+		}
+		else
+			M199_SdramRead(llHdl, offset, data, nWords, TRUE);
+		SDRAM_UNLOCK(llHdl);
+
+		error    = ERR_SUCCESS;
+		complete = FALSE;
+		req->done += nWords * 2;
+		if( req->done == req->size ){
+			complete = TRUE;
+			if( req->verify ){
+				llHdl->chVfyErr[req->ch]  = req->vfyErr;
+				llHdl->chVfyOffs[req->ch] = req->vfyOffs;
+				if( req->vfyErr ){
+					DBGWRT_ERR(( DBH, " *** M199_AsyncWork: tag 0x%x %d "
+								 "mismatch(es), first at 0x%08x\n",
+								 req->tag, req->vfyErr, req->vfyOffs));
+					error = ERR_LL_WRITE;
+				}
+			}
+		}
+		UNLOCK(llHdl,chSemHdl[req->ch]);
+
+		/* the request may be freed by the waiter after this */
+		if( complete )
+			M199_AsyncDone(llHdl, req, error);
+	}
+
+	/* restart unless M199_Cleanup stops the worker */
+	error = ERR_SUCCESS;
+	OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+	if( llHdl->asyncStop )
+		llHdl->asyncRun = FALSE;
+	else
+		error = OSS_TimerStart(llHdl->osHdl, llHdl->asyncTimHdl, delay,
+							   FALSE);
+	OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+	if( error ){
+		DBGWRT_ERR(( DBH, " *** M199_AsyncWork: can't restart worker\n"));
+		M199_AsyncAbort(llHdl, error);
+	}
+
+	OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+	llHdl->asyncBusy = FALSE;
+	OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+} /* M199_AsyncWork */
+
+/******************************* M199_AsyncDone *******************************/
+/** Complete an asynchronous SDRAM transfer
+ *
+ *  Completes the request under the list lock, so a submit can't drop it
+ *  before its waiter was signaled. The completion signal is sent under
+ *  the same lock, so M199_ASYNC_SIG_CLR can't remove it meanwhile.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param req        \IN  Request
+ *  \param error      \IN  Transfer result
+ ******************************************************************************/
+static void M199_AsyncDone(
+	LL_HANDLE	*llHdl,
+	ASYNC_REQ	*req,
+	int32		error
+)
+{
+	OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+	req->error  = error;
+	req->queued = FALSE;
+	OSS_SemSignal(llHdl->osHdl, req->doneSemHdl);
+	if( llHdl->asyncSigHdl )
+		OSS_SigSend(llHdl->osHdl, llHdl->asyncSigHdl);
+	OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+} /* M199_AsyncDone */
+
+/****************************** M199_AsyncAbort *******************************/
+/** Complete all queued asynchronous SDRAM transfers with an error
+ *
+ *  Called if the worker timer can't be started, the worker is stopped.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param error      \IN  Error code for the requests
+ ******************************************************************************/
+static void M199_AsyncAbort(
+	LL_HANDLE	*llHdl,
+	int32		error
+)
+{
+	ASYNC_REQ *req;
+
+	OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+	for (req = llHdl->asyncList; req; req = req->next){
+		if( !req->queued )
+			continue;
+		req->error  = error;
+		req->queued = FALSE;
+		OSS_SemSignal(llHdl->osHdl, req->doneSemHdl);
+	}
+	llHdl->asyncRun = FALSE;
+	if( llHdl->asyncSigHdl )
+		OSS_SigSend(llHdl->osHdl, llHdl->asyncSigHdl);
+	OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+} /* M199_AsyncAbort */
+
+/******************************* M199_AsyncFree *******************************/
+/** Free an asynchronous SDRAM transfer request
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param req        \IN  Request (not in the request list)
+ ******************************************************************************/
+static void M199_AsyncFree(
+	LL_HANDLE	*llHdl,
+	ASYNC_REQ	*req
+)
+{
+	if( req->doneSemHdl )
+		OSS_SemRemove(llHdl->osHdl, &req->doneSemHdl);
+	OSS_MemFree(llHdl->osHdl, (int8*)req, req->gotsize);
+} /* M199_AsyncFree */
+
+/******************************** M199_CmdList ********************************/
+/** Execute a command list (M199_BLK_CMD_LIST)
+ *
+ *  The whole list is checked before the first command is executed. The
+ *  commands are then executed in order while the channel (by the caller)
+ *  and the interrupt configuration are locked, so no other call of the
+ *  driver interleaves except unlocked register and counter accesses. The
+ *  list stops at the first failing command (e.g. ERR_LL_WRITE of a
+ *  verified SDRAM write), its error is returned in the command.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param ch         \IN  Current channel
+ *  \param blk        \IN  M199_CMD_LIST block
+ *                    \OUT Results of the commands and read SDRAM data
+ *
+ *  \return           \c 0 On success or error code of the list check
+ ******************************************************************************/
+static int32 M199_CmdList(
+	LL_HANDLE	*llHdl,
+	int32		ch,
+	M_SG_BLOCK	*blk
+)
+{
+	M199_CMD_LIST *list = (M199_CMD_LIST*)blk->data;
+	M199_CMD *cmd;
+	MACCESS ma = llHdl->ma;
+	u_int16 *dataP;
+	u_int32 n, width, left;
+
+	/* check command list and data size */
+	if( (u_int32)blk->size < M199_CMD_LIST_HDRSIZE(0) ||
+		list->cmdNum > ((u_int32)blk->size - M199_CMD_LIST_HDRSIZE(0)) /
+		sizeof(M199_CMD) ){
+		DBGWRT_ERR(( DBH, " *** M199_CmdList: Block size too small\n"));
+		return(ERR_LL_USERBUF);
+	}
+	/* data bytes left in the block, each SDRAM command must fit the rest */
+	left = (u_int32)blk->size - M199_CMD_LIST_HDRSIZE(list->cmdNum);
+	for (n=0; n < list->cmdNum; n++){
+		cmd = &list->cmd[n];
+		cmd->error = ERR_SUCCESS;
+		switch( cmd->op ){
+			case M199_CMD_RD16:
+			case M199_CMD_WR16:
+			case M199_CMD_RD32:
+			case M199_CMD_WR32:
+				width = (cmd->op <= M199_CMD_WR16) ? 2 : 4;
+				cmd->error = M199_UserCheck(cmd->offset, width);
+				break;
+			case M199_CMD_SDRAM_WR:
+			case M199_CMD_SDRAM_RD:
+				if( (cmd->offset & 1) || (cmd->value & 1) ||
+					cmd->offset > llHdl->chSize[ch] ||
+					cmd->value > llHdl->chSize[ch] - cmd->offset )
+					cmd->error = ERR_LL_ILL_PARAM;
+				else if( cmd->value > left )
+					cmd->error = ERR_LL_USERBUF;
+				else
+					left -= cmd->value;
+				break;
+			case M199_CMD_DELAY:
+				/* busy wait while the channel is locked */
+				if( cmd->value > M199_CMD_DELAY_MAX )
+					cmd->error = ERR_LL_ILL_PARAM;
+				break;
+			case M199_CMD_LED:
+			case M199_CMD_IRQ_ENABLE:
+				break;
+			default:
+				cmd->error = ERR_LL_ILL_PARAM;
+		}
+		if( cmd->error ){
+			DBGWRT_ERR(( DBH, " *** M199_CmdList: illegal command %d op=%d "
+						 "offset=0x%08x\n", n, cmd->op, cmd->offset));
+			return(cmd->error);
+		}
+	}
+
+	/* execute commands */
+	dataP = M199_CMD_LIST_DATA(list);
+	LOCK(llHdl,cfgSemHdl);
+	for (n=0; n < list->cmdNum; n++){
+		cmd = &list->cmd[n];
+		switch( cmd->op ){
+			case M199_CMD_RD16:
+				cmd->value = M199_MREAD_D16(ma, cmd->offset);
+				break;
+			case M199_CMD_WR16:
+				M199_MWRITE_D16(ma, cmd->offset, (u_int16)cmd->value);
+				break;
+			case M199_CMD_RD32:
+				cmd->value = M199_MREAD_D32(ma, cmd->offset);
+				break;
+			case M199_CMD_WR32:
+				M199_MWRITE_D32(ma, cmd->offset, cmd->value);
+				break;
+			case M199_CMD_LED:
+				M199_MWRITE_D16(ma, M199_LED_REG, (u_int16)(cmd->value & 0x7F));
+				break;
+			case M199_CMD_SDRAM_WR:
+				SDRAM_LOCK(llHdl);
+				M199_SdramWrite(llHdl, llHdl->chBase[ch] + cmd->offset, dataP,
+								cmd->value/2, TRUE);
+				SDRAM_UNLOCK(llHdl);
+				if( llHdl->chVerify[ch] ){
+					llHdl->chVfyErr[ch] = 0;
+					cmd->error = M199_SdramVerify(llHdl, ch, cmd->offset,
+												  dataP, cmd->value/2);
+				}
+				dataP += cmd->value/2;
+				break;
+			case M199_CMD_SDRAM_RD:
+				SDRAM_LOCK(llHdl);
+				M199_SdramRead(llHdl, llHdl->chBase[ch] + cmd->offset, dataP,
+							   cmd->value/2, TRUE);
+				SDRAM_UNLOCK(llHdl);
+				dataP += cmd->value/2;
+				break;
+			case M199_CMD_IRQ_ENABLE:
+				llHdl->irqIer = cmd->value ? llHdl->irqMask : 0;
+				M199_MWRITE_D32(ma, M199_IRQ_IER, llHdl->irqIer);
+				break;
+			case M199_CMD_DELAY:
+				OSS_MikroDelay(llHdl->osHdl, cmd->value);
+				break;
+		}
+		if( cmd->error )
+			break;
+	}
+	UNLOCK(llHdl,cfgSemHdl);
+	list->done = n;
+
+	return(ERR_SUCCESS);
+} /* M199_CmdList */
+
+/******************************* M199_UserCheck *******************************/
+/** Check a user module register range
+ *
+ *  The user module occupies the registers below the interrupt registers.
+ *  In A24 mode these offsets address the SDRAM window, so there are no
+ *  user module registers.
+ *
+ *  \param offset     \IN  Register offset [bytes]
+ *  \param size       \IN  Size of the range [bytes]
+ *
+ *  \return           \c 0 On success or ERR_LL_ILL_PARAM
+ ******************************************************************************/
+static int32 M199_UserCheck(
+	u_int32		offset,
+	u_int32		size
+)
+{
+	if( (offset & 1) || size == 0 || offset > M199_USER_SIZE ||
+		size > M199_USER_SIZE - offset )
+		return(ERR_LL_ILL_PARAM);
+	return(ERR_SUCCESS);
+} /* M199_UserCheck */
+
+/******************************** M199_UserReg ********************************/
+/** Read or write user module registers (M199_BLK_USER_REG)
+ *
+ *  D32 registers are accessed like the interrupt registers, low word
+ *  first (see M199_MREAD_D32).
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param blk        \IN  M199_USER_REG block
+ *                    \OUT Read register values
+ *  \param write      \IN  TRUE: write registers
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_UserReg(
+	LL_HANDLE	*llHdl,
+	M_SG_BLOCK	*blk,
+	int32		write
+)
+{
+	M199_USER_REG *ur = (M199_USER_REG*)blk->data;
+	MACCESS ma = llHdl->ma;
+	u_int32 n, offs, *valP;
+
+	if( blk->size < M199_USER_REG_MINSIZE ||
+		ur->num > ((u_int32)blk->size - M199_USER_REG_MINSIZE) /
+		sizeof(u_int32) ){
+		DBGWRT_ERR(( DBH, " *** M199_UserReg: Block size too small\n"));
+		return(ERR_LL_USERBUF);
+	}
+	if( (ur->width != 2 && ur->width != 4) ||
+		ur->num > M199_USER_SIZE / ur->width ||
+		M199_UserCheck(ur->offset, ur->num * ur->width) ){
+		DBGWRT_ERR(( DBH, " *** M199_UserReg: illegal range offset=0x%x "
+					 "num=%d width=%d\n", ur->offset, ur->num, ur->width));
+		return(ERR_LL_ILL_PARAM);
+	}
+
+	offs = ur->offset;
+	valP = ur->val;
+	if( ur->width == 2 ){
+		for (n=0; n < ur->num; n++, offs += 2, valP++){
+			if( write )
+				M199_MWRITE_D16(ma, offs, (u_int16)*valP);
+			else
+				*valP = M199_MREAD_D16(ma, offs);
+		}
+	}
+	else {
+		for (n=0; n < ur->num; n++, offs += 4, valP++){
+			if( write )
+				M199_MWRITE_D32(ma, offs, *valP)
+			else
+				*valP = M199_MREAD_D32(ma, offs);
+		}
+	}
+	return(ERR_SUCCESS);
+} /* M199_UserReg */
+
+/******************************** M199_RegWait ********************************/
+/** Wait for a user module register value (M199_BLK_REG_WAIT)
+ *
+ *  Polls the register in the driver instead of one call per poll. The
+ *  device is not locked while waiting. Between the polls the driver either
+ *  delays busy (OSS_MikroDelay) or sleeps (OSS_Delay, M199_REG_WAIT_SLEEP).
+ *  A busy wait is limited to M199_REG_WAIT_BUSY_MAX ms (interval in us),
+ *  an endless wait must sleep.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param rw         \IN  Register, condition and poll policy
+ *                    \OUT Last register value, wait time and polls
+ *
+ *  \return           \c 0 On success (also on timeout) or error code
+ ******************************************************************************/
+static int32 M199_RegWait(
+	LL_HANDLE		*llHdl,
+	M199_REG_WAIT	*rw
+)
+{
+	MACCESS ma = llHdl->ma;
+	u_int32 start, secs, ticks, rate = OSS_TickRateGet(llHdl->osHdl);
+	int32 sleep = (rw->flags & M199_REG_WAIT_SLEEP) ? TRUE : FALSE;
+
+	if( (rw->width != 2 && rw->width != 4) ||
+		M199_UserCheck(rw->offset, rw->width) ||
+		(!sleep && (rw->timeout < 0 ||
+					rw->timeout > M199_REG_WAIT_BUSY_MAX ||
+					rw->interval > M199_REG_WAIT_BUSY_MAX * 1000)) ){
+		DBGWRT_ERR(( DBH, " *** M199_RegWait: illegal parameter offset=0x%x "
+					 "width=%d timeout=%d interval=%d\n", rw->offset,
+					 rw->width, rw->timeout, rw->interval));
+		return(ERR_LL_ILL_PARAM);
+	}
+
+	/* ms to ticks, divided first (timeout * rate exceeds 32 bit) */
+	secs = (u_int32)rw->timeout / 1000;
+	if( secs < 0x7fffffff / rate )
+		ticks = secs * rate +
+				((u_int32)rw->timeout % 1000) * rate / 1000 + 1;
+	else
+		ticks = 0x7fffffff;
+	start = OSS_TickGet(llHdl->osHdl);
+	rw->polls = 0;
+
+	for (;;) {
+		rw->regVal = (rw->width == 2) ? M199_MREAD_D16(ma, rw->offset) :
+					 M199_MREAD_D32(ma, rw->offset);
+		rw->polls++;
+		if( (rw->regVal & rw->mask) == rw->value || rw->timeout == 0 ||
+			(rw->timeout > 0 && OSS_TickGet(llHdl->osHdl) - start > ticks) )
+			break;
+
+		if( sleep )
+			OSS_Delay(llHdl->osHdl, (rw->interval + 999) / 1000);
+		else if( rw->interval )
+			OSS_MikroDelay(llHdl->osHdl, rw->interval);
+	}
+
+	ticks = OSS_TickGet(llHdl->osHdl) - start;
+	rw->elapsed = (ticks / rate) * 1000 + ((ticks % rate) * 1000) / rate;
+
+	return(ERR_SUCCESS);
+} /* M199_RegWait */
+
+/******************************** M199_IrqWait ********************************/
+/** Wait for the next interrupt event (M199_BLK_IRQ_WAIT)
+ *
+ *  The wait is called without a driver lock, so other calls to the device
+ *  are not blocked.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param wait       \IN  Wait time
+ *                    \OUT Event, lost events and tick rate
+ *
+ *  \return           \c 0 On success or error code (ERR_OSS_TIMEOUT)
+ ******************************************************************************/
+static int32 M199_IrqWait(
+	LL_HANDLE		*llHdl,
+	M199_IRQ_WAIT	*wait
+)
+{
+	OSS_IRQ_STATE irqState;
+	int32 error, got = FALSE;
+	int32 timeout = (wait->timeout < 0) ? OSS_SEM_WAITFOREVER :
+					(wait->timeout == 0) ? OSS_SEM_NOWAIT : wait->timeout;
+
+	do {
+		error = OSS_SemWait(llHdl->osHdl, llHdl->irqSemHdl, timeout);
+		if( error )
+			return(error);
+
+		/* dequeue (queue may have been cleared meanwhile) */
+		irqState = OSS_IrqMaskR(llHdl->osHdl, llHdl->irqHdl);
+		if( llHdl->irqEvNum ){
+			wait->ev.irr  = llHdl->irqEvIrr[llHdl->irqEvOut];
+			wait->ev.tick = llHdl->irqEvTick[llHdl->irqEvOut];
+			wait->lost = llHdl->irqEvLost;
+			llHdl->irqEvOut = (llHdl->irqEvOut + 1) % IRQ_EVQ_SIZE;
+			llHdl->irqEvNum--;
+			llHdl->irqEvLost = 0;
+			got = TRUE;
+		}
+		OSS_IrqRestore(llHdl->osHdl, llHdl->irqHdl, irqState);
+	} while( !got );
+
+	wait->tickRate = OSS_TickRateGet(llHdl->osHdl);
+
+	return(ERR_SUCCESS);
+} /* M199_IrqWait */
+
+/******************************** M199_IrqClear *******************************/
+/** Clear the interrupt event queue and the interrupt counters
+ *
+ *  \param llHdl      \IN  Low-level handle
+ ******************************************************************************/
+static void M199_IrqClear(
+	LL_HANDLE	*llHdl
+)
+{
+	OSS_IRQ_STATE irqState;
+	u_int32 n;
+
+	/* consume queued events */
+	while( OSS_SemWait(llHdl->osHdl, llHdl->irqSemHdl, OSS_SEM_NOWAIT) == 0 )
+		;
+
+	irqState = OSS_IrqMaskR(llHdl->osHdl, llHdl->irqHdl);
+	llHdl->irqEvIn   = 0;
+	llHdl->irqEvOut  = 0;
+	llHdl->irqEvNum  = 0;
+	llHdl->irqEvLost = 0;
+	llHdl->irqCount  = 0;
+	for (n=0; n < M199_IRQ_SRC_NUM; n++)
+		llHdl->irqSrcCount[n] = 0;
+	OSS_IrqRestore(llHdl->osHdl, llHdl->irqHdl, irqState);
+} /* M199_IrqClear */
+
+/******************************* M199_FlashAddr *******************************/
+/** Set the flash address register
+ *
+ *  The upper half of the address register is only written if it differs
+ *  from the last written value, so sequential reads need one D16 address
+ *  write per word.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param addr       \IN  Flash offset [bytes]
+ ******************************************************************************/
+static void M199_FlashAddr(
+	LL_HANDLE	*llHdl,
+	u_int32		addr
+)
+{
+	llHdl->statFlashAddr++;
+	if( (addr >> 16) != llHdl->flashAddrHi ){
+		llHdl->flashAddrHi = addr >> 16;
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_ADDR + 2, (u_int16)(addr >> 16) );
+	}
+	M199_MWRITE_D16( llHdl->ma, M199_FLASH_ADDR, (u_int16)(addr & 0xffff) );
+} /* M199_FlashAddr */
+
+/******************************* M199_FlashRead *******************************/
+/** Read words from the flash
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param offset     \IN  Flash offset [bytes]
+ *  \param dataP      \OUT Read words (NULL: only build the sum)
+ *  \param nWords     \IN  Number of words
+ *
+ *  \return           32-bit sum of the read words
+ ******************************************************************************/
+static u_int32 M199_FlashRead(
+	LL_HANDLE	*llHdl,
+	u_int32		offset,
+	u_int16		*dataP,
+	u_int32		nWords
+)
+{
+	u_int32 n, sum = 0;
+	u_int16 val;
+
+	llHdl->statFlashRd += nWords * 2;
+	M199_FlashAddr( llHdl, offset );
+	M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA , 0xFFFF );	/* READ-MODE */
+
+	for (n = 0; n < nWords; n++)
+	{
+		M199_FlashAddr( llHdl, offset + (n*2) );
+		val = (u_int16)M199_MREAD_D16( llHdl->ma, M199_FLASH_DATA );
+		val = (u_int16)OSS_SWAP16(val);
+		sum += val;
+		if( dataP )
+			dataP[n] = val;
+	}
+
+	return(sum);
+} /* M199_FlashRead */
+
+/******************************* M199_FlashWait *******************************/
+/** Wait until the flash write state machine is ready
+ *
+ *  Must be called after an erase or program command, the flash then
+ *  returns its status register on reads.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param offset     \IN  Flash offset of the operation [bytes]
+ *  \param timeout    \IN  Timeout [ms]
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_FlashWait(
+	LL_HANDLE	*llHdl,
+	u_int32		offset,
+	int32		timeout
+)
+{
+	u_int32 start, ticks;
+	u_int16 status;
+
+	ticks = (timeout * OSS_TickRateGet(llHdl->osHdl)) / 1000 + 1;
+	start = OSS_TickGet(llHdl->osHdl);
+
+	while( !((status = M199_MREAD_D16( llHdl->ma, M199_FLASH_DATA ))
+			 & FLASH_SR_READY) ){
+		if( OSS_TickGet(llHdl->osHdl) - start > ticks ){
+			status = 0;
+			break;
+		}
+		/* erase takes seconds, don't spin */
+		if( timeout > FLASH_PROG_TIMEOUT )
+			OSS_Delay(llHdl->osHdl, 1);
+	}
+
+	if( !(status & FLASH_SR_READY) || (status & FLASH_SR_ERROR) ){
+		DBGWRT_ERR(( DBH, " *** M199_FlashWait: offset 0x%08x status "
+					 "0x%04x\n", offset, status));
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_CLRSTAT );
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_READ );
+		llHdl->flashErrOffs = offset;
+		llHdl->flashErrStat = status;
+		return( status ? ERR_LL_WRITE : ERR_OSS_TIMEOUT );
+	}
+
+	return(ERR_SUCCESS);
+} /* M199_FlashWait */
+
+/******************************* M199_FlashProg *******************************/
+/** Program flash sectors (M199_BLK_FLASH_PROG)
+ *
+ *  Each sector is compared with the new data first and skipped if it is
+ *  unchanged (unless M199_FLASH_PROG_FORCE). Otherwise the sector is
+ *  unlocked, erased, programmed (erased words are not programmed) and
+ *  verified. The progress is available with M199_BLK_FLASH_STAT.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param fp         \IN  Checked M199_FLASH_PROG block
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_FlashProg(
+	LL_HANDLE		*llHdl,
+	M199_FLASH_PROG	*fp
+)
+{
+	u_int32 sect, n, nWords, sectWords = llHdl->flashSectSize / 2;
+	u_int32 offset;
+	u_int16 *dataP, val;
+	int32 error;
+
+	if( fp->flags & M199_FLASH_PROG_FIRST ){
+		llHdl->flashSectDone  = 0;
+		llHdl->flashSectSkip  = 0;
+		llHdl->flashSectProg  = 0;
+		llHdl->flashBytesDone = 0;
+		llHdl->flashErrOffs   = 0;
+		llHdl->flashErrStat   = 0;
+	}
+
+	for (sect = 0; sect * llHdl->flashSectSize < fp->size; sect++)
+	{
+		offset = fp->offset + sect * llHdl->flashSectSize;
+		dataP  = &fp->buf[sect * sectWords];
+		nWords = (fp->size / 2) - sect * sectWords;
+		if( nWords > sectWords )
+			nWords = sectWords;
+
+		/*--- compare, remainder of a partial sector must be erased ---*/
+		if( !(fp->flags & M199_FLASH_PROG_FORCE) ){
+			M199_FlashAddr( llHdl, offset );
+			M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_READ );
+			for (n = 0; n < sectWords; n++){
+				M199_FlashAddr( llHdl, offset + (n*2) );
+				val = (u_int16)M199_MREAD_D16( llHdl->ma, M199_FLASH_DATA );
+				val = (u_int16)OSS_SWAP16(val);
+				if( val != ((n < nWords) ? dataP[n] : 0xFFFF) )
+					break;
+			}
+			llHdl->statFlashRd += ((n < sectWords) ? n + 1 : n) * 2;
+			if( n == sectWords ){
+				llHdl->flashSectSkip++;
+				llHdl->flashSectDone++;
+				llHdl->flashBytesDone += nWords * 2;
+				continue;
+			}
+		}
+
+		DBGWRT_2((DBH, " M199_FlashProg: program sector at 0x%08x\n", offset));
+
+		/*--- unlock and erase ---*/
+		M199_FlashAddr( llHdl, offset );
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_CLRSTAT );
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_LOCK );
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_CONFIRM );
+		if( (error = M199_FlashWait( llHdl, offset, FLASH_ERASE_TIMEOUT )) )
+			return(error);
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_ERASE );
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_CONFIRM );
+		if( (error = M199_FlashWait( llHdl, offset, FLASH_ERASE_TIMEOUT )) )
+			return(error);
+
+		/*--- program ---*/
+		for (n = 0; n < nWords; n++){
+			if( dataP[n] == 0xFFFF )
+				continue;
+			M199_FlashAddr( llHdl, offset + (n*2) );
+			M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_PROG );
+			M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA,
+							 (u_int16)OSS_SWAP16(dataP[n]) );
+			if( (error = M199_FlashWait( llHdl, offset + (n*2),
+										 FLASH_PROG_TIMEOUT )) )
+				return(error);
+			llHdl->statFlashWr += 2;
+		}
+
+		/*--- verify ---*/
+		M199_MWRITE_D16( llHdl->ma, M199_FLASH_DATA, FLASH_CMD_READ );
+		for (n = 0; n < nWords; n++){
+			M199_FlashAddr( llHdl, offset + (n*2) );
+			val = (u_int16)M199_MREAD_D16( llHdl->ma, M199_FLASH_DATA );
+			val = (u_int16)OSS_SWAP16(val);
+			if( val != dataP[n] ){
+				DBGWRT_ERR(( DBH, " *** M199_FlashProg: verify error at "
+							 "0x%08x\n", offset + (n*2)));
+				llHdl->flashErrOffs = offset + (n*2);
+				llHdl->flashErrStat = 0;
+				return(ERR_LL_WRITE);
+			}
+		}
+		llHdl->statFlashRd += nWords * 2;
+
+		llHdl->flashSectProg++;
+		llHdl->flashSectDone++;
+		llHdl->flashBytesDone += nWords * 2;
+
+		/* refresh cached FPGA header */
+		if( offset == 0 )
+			M199_FlashRead(llHdl, 0, llHdl->fpgaHdr, M199_FPGA_HEADER_SIZE);
+	}
+
+	return(ERR_SUCCESS);
+} /* M199_FlashProg */
+
+/******************************** M199_UsmRead ********************************/
+/** Read words from the USM EEPROM
+ *
+ *  If the USM EEPROM shadow is enabled, it is filled on first access
+ *  and the words are taken from the shadow.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param offset     \IN  First word
+ *  \param count      \IN  Number of words
+ *  \param dataP      \OUT Read words
+ ******************************************************************************/
+static void M199_UsmRead(
+	LL_HANDLE	*llHdl,
+	u_int32		offset,
+	u_int32		count,
+	u_int16		*dataP
+)
+{
+	u_int32 n;
+
+	if( !llHdl->usmCache ){
+		llHdl->statUsmRd += count * 2;
+		for(n = 0; n < count; n++)
+			dataP[n] = (u_int16)usm_read((U_INT32_OR_64)llHdl->ma,
+										 (u_int8)(offset + n));
+		return;
+	}
+
+	if( !llHdl->usmValid ){
+		llHdl->statUsmRd += M199_USM_SIZE * 2;
+		for(n = 0; n < M199_USM_SIZE; n++)
+			llHdl->usmShadow[n] = (u_int16)usm_read((U_INT32_OR_64)llHdl->ma,
+													(u_int8)n);
+		llHdl->usmValid = TRUE;
+	}
+	for(n = 0; n < count; n++)
+		dataP[n] = llHdl->usmShadow[offset + n];
+} /* M199_UsmRead */
+
+/******************************** M199_UsmWrite *******************************/
+/** Write the USM EEPROM
+ *
+ *  After each word the EEPROM is polled until the word reads back
+ *  (write cycle completed) or USM_WR_TIMEOUT expires.
+ *  In update mode the current content is read first (from the shadow
+ *  if valid) and only the differing words are written. The shadow is
+ *  kept up to date. The number of written words is
+ *  returned by the M199_USM_WR_COUNT Getstat.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param dataP      \IN  M199_USM_SIZE words to write
+ *  \param update     \IN  TRUE: write changed words only
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_UsmWrite(
+	LL_HANDLE	*llHdl,
+	u_int16		*dataP,
+	int32		update
+)
+{
+	u_int8 n;
+	u_int32 start, timeout;
+
+	timeout = (USM_WR_TIMEOUT * OSS_TickRateGet(llHdl->osHdl)) / 1000 + 1;
+	llHdl->usmWrCount = 0;
+
+	for(n = 0; n < M199_USM_SIZE; n++)
+	{
+		if( update ){
+			u_int16 cur;
+
+			M199_UsmRead(llHdl, n, 1, &cur);
+			if( cur == dataP[n] )
+				continue;
+		}
+
+		usm_write((u_int8 *)llHdl->ma,n,dataP[n]);
+		llHdl->usmWrCount++;
+		llHdl->statUsmWr += 2;
+
+		/* wait for end of write cycle */
+		start = OSS_TickGet(llHdl->osHdl);
+		while( (u_int16)usm_read((U_INT32_OR_64)llHdl->ma,n) != dataP[n] ){
+			if( OSS_TickGet(llHdl->osHdl) - start > timeout ){
+				DBGWRT_ERR(( DBH, " *** M199_UsmWrite: timeout word %d\n", n));
+				llHdl->usmValid = FALSE;
+				return(ERR_LL_WRITE);
+			}
+		}
+		llHdl->usmShadow[n] = dataP[n];
+	}
+
+	return(ERR_SUCCESS);
+} /* M199_UsmWrite */
+
+/******************************** M199_CodeSem ********************************/
+/** Return the lock of a Getstat/Setstat code
+ *
+ *  The driver runs with LL_LOCK_NONE. Only the codes that use an indexed
+ *  port (flash, A08 SDRAM) or the serial EEPROMs, or that modify shared
+ *  state are locked. Single register accesses (LED) and reading of
+ *  counters or cached data are not locked.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param code       \IN  Status code
+ *  \param ch         \IN  Current channel
+ *
+ *  \return           Semaphore to hold or NULL
+ ******************************************************************************/
+static OSS_SEM_HANDLE *M199_CodeSem(
+	LL_HANDLE	*llHdl,
+	int32		code,
+	int32		ch
+)
+{
+	switch(code) {
+		/* channel block i/o position and data */
+		case M199_SDRAM_POS:
+		case M199_SDRAM_VERIFY:
+		case M199_BLK_SDRAM:
+		case M199_BLK_SDRAM_SG:
+		case M199_BLK_VERIFY_STAT:
+		case M199_BLK_SDRAM_TEST:
+		case M199_BLK_SDRAM_FILL:
+		case M199_BLK_SDRAM_COPY:
+		case M199_BLK_SDRAM_CHECK:
+		case M199_BLK_SDRAM_FIND:
+		case M199_BLK_CMD_LIST:
+			return(llHdl->chSemHdl[ch]);
+		/* flash port (the progress M199_BLK_FLASH_STAT is read unlocked) */
+		case M199_BLK_FLASH:
+		case M199_BLK_FLASH_PROG:
+			return(llHdl->flashSemHdl);
+		/* serial EEPROMs and USM shadow */
+		case M199_BLK_USM_MODULE:
+		case M199_BLK_USM_UPDATE:
+		case M199_BLK_USM_PART:
+		case M199_USM_CACHE:
+		case M_LL_BLK_ID_DATA:
+			return(llHdl->eepromSemHdl);
+		/* interrupt and signal configuration */
+		case M_MK_IRQ_ENABLE:
+		case M199_IRQ_MASK:
+		case M199_IRQ_CLR:
+		case M199_SIG_SET:
+		case M199_SIG_CLR:
+		case M199_ASYNC_SIG_SET:
+		case M199_ASYNC_SIG_CLR:
+			return(llHdl->cfgSemHdl);
+		default:
+			return(NULL);
+	}
+} /* M199_CodeSem */
+
+/****************************** M199_SdramChInit ******************************/
+/** Read the SDRAM channel partitioning from the descriptor
+ *
+ *  By default the SDRAM is divided into SDRAM_CH_NUM equal parts.
+ *  The channel areas must be word aligned, not empty and must not overlap.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_SdramChInit(
+	LL_HANDLE	*llHdl
+)
+{
+	u_int32 ch, n, part;
+	int32 retCode;
+
+    retCode = DESC_GetUInt32(llHdl->descHdl,
+    						 1,
+					 		 &llHdl->chNum,
+					 		 "SDRAM_CH_NUM");
+    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+		DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"SDRAM_CH_NUM\" = 0x%08lx\n",retCode));
+		return(retCode);
+	}
+	if( llHdl->chNum == 0 || llHdl->chNum > M199_CH_MAX ){
+		DBGWRT_ERR(( DBH, " *** M199_Init: illegal SDRAM_CH_NUM\n"));
+		return(ERR_LL_DESC_PARAM);
+	}
+	part = (M199_SDRAM_SIZE / llHdl->chNum) & ~1;
+
+	for (ch=0; ch < llHdl->chNum; ch++){
+	    retCode = DESC_GetUInt32(llHdl->descHdl,
+	    						 ch * part,
+						 		 &llHdl->chBase[ch],
+						 		 "CHANNEL_%d/SDRAM_BASE", ch);
+	    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+			DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"CHANNEL_%d/SDRAM_BASE\" = 0x%08lx\n",ch,retCode));
+			return(retCode);
+		}
+	    retCode = DESC_GetUInt32(llHdl->descHdl,
+	    						 part,
+						 		 &llHdl->chSize[ch],
+						 		 "CHANNEL_%d/SDRAM_SIZE", ch);
+	    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+			DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"CHANNEL_%d/SDRAM_SIZE\" = 0x%08lx\n",ch,retCode));
+			return(retCode);
+		}
+
+		/* check range and overlapping with the previous channels */
+		if( (llHdl->chBase[ch] & 1) || (llHdl->chSize[ch] & 1) ||
+			llHdl->chSize[ch] == 0 ||
+			llHdl->chBase[ch] > M199_SDRAM_SIZE ||
+			llHdl->chSize[ch] > M199_SDRAM_SIZE - llHdl->chBase[ch] ){
+			DBGWRT_ERR(( DBH, " *** M199_Init: illegal SDRAM area channel %d\n",
+						 ch));
+			return(ERR_LL_DESC_PARAM);
+		}
+		for (n=0; n < ch; n++){
+			if( llHdl->chBase[ch] < llHdl->chBase[n] + llHdl->chSize[n] &&
+				llHdl->chBase[n] < llHdl->chBase[ch] + llHdl->chSize[ch] ){
+				DBGWRT_ERR(( DBH, " *** M199_Init: SDRAM area channel %d "
+							 "overlaps channel %d\n", ch, n));
+				return(ERR_LL_DESC_PARAM);
+			}
+		}
+		DBGWRT_2((DBH, " ch%d: SDRAM base=0x%08x size=0x%08x\n",
+				  ch, llHdl->chBase[ch], llHdl->chSize[ch]));
+	}
+
+	return(ERR_SUCCESS);
+} /* M199_SdramChInit */
+
+/****************************** M199_UserChInit *******************************/
+/** Read the channel user registers from the descriptor
+ *
+ *  Each channel may have one user module register for M_read()/M_write().
+ *  The A24 variants have no user module registers.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 M199_UserChInit(
+	LL_HANDLE	*llHdl
+)
+{
+	u_int32 ch;
+	int32 retCode;
+
+	for (ch=0; ch < llHdl->chNum; ch++){
+	    retCode = DESC_GetUInt32(llHdl->descHdl,
+	    						 0,
+						 		 &llHdl->chReg[ch],
+						 		 "CHANNEL_%d/USER_REG", ch);
+	    if (retCode == ERR_DESC_KEY_NOTFOUND)
+			continue;			/* no register */
+	    if (retCode != 0){
+			DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"CHANNEL_%d/USER_REG\" = 0x%08lx\n",ch,retCode));
+			return(retCode);
+		}
+	    retCode = DESC_GetUInt32(llHdl->descHdl,
+	    						 2,
+						 		 &llHdl->chRegWidth[ch],
+						 		 "CHANNEL_%d/USER_WIDTH", ch);
+	    if (retCode != 0 && retCode != ERR_DESC_KEY_NOTFOUND){
+			DBGWRT_ERR(( DBH, " *** M199_Init: DESC Error \"CHANNEL_%d/USER_WIDTH\" = 0x%08lx\n",ch,retCode));
+			return(retCode);
+		}
+
+		if( (llHdl->chRegWidth[ch] != 2 && llHdl->chRegWidth[ch] != 4) ||
+			M199_UserCheck(llHdl->chReg[ch], llHdl->chRegWidth[ch]) ){
+			DBGWRT_ERR(( DBH, " *** M199_Init: illegal user register "
+						 "channel %d\n", ch));
+			return(ERR_LL_DESC_PARAM);
+		}
+		DBGWRT_2((DBH, " ch%d: user register 0x%02x D%d\n",
+				  ch, llHdl->chReg[ch], llHdl->chRegWidth[ch] * 8));
+	}
+
+	return(ERR_SUCCESS);
+} /* M199_UserChInit */
+
+/******************************** M199_StatsGet *******************************/
+/** Copy the statistics of the handle
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param st         \OUT statistics
+ ******************************************************************************/
+static void M199_StatsGet(
+	LL_HANDLE	*llHdl,
+	M199_STATS	*st
+)
+{
+	u_int32 n;
+
+	st->tickRate	 = (u_int32)OSS_TickRateGet(llHdl->osHdl);
+	st->d16Rd		 = llHdl->statD16Rd;
+	st->d16Wr		 = llHdl->statD16Wr;
+	st->d32Rd		 = llHdl->statD32Rd;
+	st->d32Wr		 = llHdl->statD32Wr;
+	st->sdramAddrSet = llHdl->statSdramAddr;
+	st->flashAddrSet = llHdl->statFlashAddr;
+	st->sdramRd		 = llHdl->statSdramRd;
+	st->sdramWr		 = llHdl->statSdramWr;
+	st->flashRd		 = llHdl->statFlashRd;
+	st->flashWr		 = llHdl->statFlashWr;
+	st->usmRd		 = llHdl->statUsmRd;
+	st->usmWr		 = llHdl->statUsmWr;
+	st->blkRdCalls	 = llHdl->statBlkRdCalls;
+	st->blkRdTicks	 = llHdl->statBlkRdTicks;
+	st->blkWrCalls	 = llHdl->statBlkWrCalls;
+	st->blkWrTicks	 = llHdl->statBlkWrTicks;
+
+	for(n = 0; n < M199_STAT_CODE_NUM; n++){
+		st->setCalls[n] = llHdl->statSetCalls[n];
+		st->setTicks[n] = llHdl->statSetTicks[n];
+		st->getCalls[n] = llHdl->statGetCalls[n];
+		st->getTicks[n] = llHdl->statGetTicks[n];
+	}
+} /* M199_StatsGet */
+
+/********************************* M199_Cleanup *******************************/
+/** Close all handles, free memory and return error code
+ *
+ *	\warning The low-level handle is invalid after this function is called.
+ *
+ *  \param llHdl      \IN  Low-level handle
+ *  \param retCode    \IN  Return value
+ *
+ *  \return           \IN   retCode
+ ******************************************************************************/
+static int32 M199_Cleanup(
+   LL_HANDLE    *llHdl,
+   int32        retCode
+)
+{
+	u_int32 n;
+
+	DBGWRT_1(( DBH, " Cleanup (M199) \n"));
+    /*------------------------------+
+    |  close handles                |
+    +------------------------------*/
+	/* stop async worker: no restart, wait for a running callback,
+	   then discard pending transfers */
+	if (llHdl->asyncSplHdl){
+		OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+		llHdl->asyncStop = TRUE;
+		OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+	}
+	if (llHdl->asyncTimHdl){
+		OSS_TimerStop(llHdl->osHdl, llHdl->asyncTimHdl);
+		for (;;){
+			OSS_SpinLockAcquire(llHdl->osHdl, llHdl->asyncSplHdl);
+			n = llHdl->asyncBusy;
+			OSS_SpinLockRelease(llHdl->osHdl, llHdl->asyncSplHdl);
+			if (!n)
+				break;
+			OSS_Delay(llHdl->osHdl, ASYNC_RETRY);
+		}
+		OSS_TimerRemove(llHdl->osHdl, &llHdl->asyncTimHdl);
+	}
+	while (llHdl->asyncList){
+		ASYNC_REQ *req = llHdl->asyncList;
+
+		llHdl->asyncList = req->next;
+		M199_AsyncFree(llHdl, req);
+	}
+	if (llHdl->asyncSplHdl)
+		OSS_SpinLockRemove(llHdl->osHdl, &llHdl->asyncSplHdl);
+	if (llHdl->asyncSigHdl)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->asyncSigHdl);
+
+	/* clean up signal and semaphore */
+	if (llHdl->sigHdl)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->sigHdl);
+	if (llHdl->irqSemHdl)
+		OSS_SemRemove(llHdl->osHdl, &llHdl->irqSemHdl);
+	if (llHdl->cfgSemHdl)
+		OSS_SemRemove(llHdl->osHdl, &llHdl->cfgSemHdl);
+	if (llHdl->flashSemHdl)
+		OSS_SemRemove(llHdl->osHdl, &llHdl->flashSemHdl);
+	if (llHdl->eepromSemHdl)
+		OSS_SemRemove(llHdl->osHdl, &llHdl->eepromSemHdl);
+	if (llHdl->sdramSemHdl)
+		OSS_SemRemove(llHdl->osHdl, &llHdl->sdramSemHdl);
+	for (n=0; n < M199_CH_MAX; n++)
+		if (llHdl->chSemHdl[n])
+			OSS_SemRemove(llHdl->osHdl, &llHdl->chSemHdl[n]);
+
 	/* clean up desc */
 	if (llHdl->descHdl)
 		DESC_Exit(&llHdl->descHdl);
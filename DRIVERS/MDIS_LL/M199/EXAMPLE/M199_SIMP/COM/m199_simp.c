@@ -200,7 +200,8 @@ int main(int argc, char *argv[])
    	if(UTL_TSTOPT("f"))
 	{
 		M_SG_BLOCK msgblk;
-		u_int16 fpgaheadercontent[128];
+		u_int16 fpgaheadercontent[M199_FPGA_HEADER_SIZE];
+		M199_FPGA_INFO fpgainfo;
 		msgblk.data = fpgaheadercontent;
 		msgblk.size = sizeof(fpgaheadercontent);
 		value = 0;
@@ -217,12 +218,14 @@ int main(int argc, char *argv[])
 			printf(" 0x%04x",fpgaheadercontent[index_i]);
 		}
 		printf("\n");
-		printf("\n Filename: ");
-    	for (index_i = 0; index_i < 14; index_i++)
-    	{
-    		printf("%c%c",fpgaheadercontent[index_i+2]>>8,fpgaheadercontent[index_i+2]);
-    	}
-    	printf("\n\n");
+
+		msgblk.data = &fpgainfo;
+		msgblk.size = sizeof(fpgainfo);
+		if ((M_getstat(path, M199_BLK_FPGA_INFO, (int32*)&msgblk)) < 0) {
+				PrintError("getstat");
+				goto abort;
+		}
+		printf("\n Filename: %s\n\n", fpgainfo.fileName);
 	}
 	/*---------------------------------+
     |  read / write data to the SDRAM  |
@@ -274,24 +277,22 @@ int main(int argc, char *argv[])
 		msgblk.data 	= (u_int16*)&blksdram;
 
 		printf("Write predefined values to SDRAM at the offset 0x%08lx\n",blksdram.offset);
-		M_setstat(path, M199_BLK_SDRAM, (U_INT32_OR_64)&msgblk);
-
-		/* clear the buffer */
-		for (index_i = 0; index_i < M199_SDRAM_BUFFER_SIZE; index_i++){
-			blksdram.buf[index_i] = 0;
-		}
 
-		blksdram.size = M199_SDRAM_BUFFER_SIZE * 2;
-		M_getstat(path, M199_BLK_SDRAM,(int32*)&msgblk);
+		/* the driver reads the data back and compares it */
+		M_setstat(path, M199_SDRAM_VERIFY, TRUE);
+		if( M_setstat(path, M199_BLK_SDRAM, (U_INT32_OR_64)&msgblk) < 0 ){
+			M199_VERIFY_STAT vfy;
 
-		for (index_i = 0; index_i < M199_SDRAM_BUFFER_SIZE; index_i++)
-		{
-			if(!(index_i %8)){
-				printf("\n %08lx: ",index_i / 8);
-			}
-			printf(" %04x",blksdram.buf[index_i]);
+			PrintError("setstat");
+			msgblk.size = sizeof(vfy);
+			msgblk.data = &vfy;
+			if( M_getstat(path, M199_BLK_VERIFY_STAT, (int32*)&msgblk) == 0 )
+				printf("%ld word(s) differ, first at offset 0x%08lx\n",
+					   (long)vfy.errCount, (long)vfy.errOffset);
 		}
-		printf("\n");
+		else
+			printf("Data verified\n");
+		M_setstat(path, M199_SDRAM_VERIFY, FALSE);
 	}
 
 	/*--------------------+
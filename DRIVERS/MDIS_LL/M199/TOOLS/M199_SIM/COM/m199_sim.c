@@ -0,0 +1,538 @@
+/*********************  P r o g r a m  -  M o d u l e *************************/
+/*!
+ *        \file  m199_sim.c
+ *
+ *      \author  ck
+ *
+ *      \brief   Register-level model of the M199 M-Module
+ *
+ *               Models the register map seen by the driver through the
+ *               MACCESS handle (see m199_sim.h):
+ *
+ *               - 0x00..0xCF user module, plain registers
+ *               - 0xD0/0xD8 IRR (write 1 to clear) and IER
+ *               - 0xE0 LED register
+ *               - 0xE8/0xEC autoincrementing SDRAM address/data port
+ *               - 0xF0/0xF4 flash address/data port (Intel command set)
+ *               - A24: SDRAM window, overlaid by the register block
+ *                 0xD0..0xFF which is decoded in both address spaces
+ *
+ *               The ID PROM and USM EEPROM are modelled on the level of
+ *               the ID library functions m_read(), usm_read() and
+ *               usm_write(), which replace the ID library.
+ *
+ *               The bus values are in host order like MAC_MEM_MAPPED
+ *               accesses, the access functions swap them with
+ *               MAC_BYTESWAP like maccess.h. A register value as seen by
+ *               the driver is the byte swapped bus value (or the bus value
+ *               with MAC_BYTESWAP). The flash image holds the bytes in the
+ *               order they are stored in the flash.
+ *
+ *     Required: -
+ *     \switches M199_A24, MAC_BYTESWAP
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2007-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <MEN/men_typs.h>
+#include <MEN/oss.h>
+#include <MEN/modcom.h>
+#include <MEN/m199_sim.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+/* registers (see m199_drv.c) */
+#define REG_IRR			0xD0		/**< Interrupt Request Register */
+#define REG_IER			0xD8		/**< Interrupt Enable Register */
+#define REG_SDRAM_ADDR	0xE8		/**< SDRAM address register */
+#define REG_SDRAM_DATA	0xEC		/**< SDRAM data register */
+#define REG_FLASH_ADDR	0xF0		/**< Flash address register */
+#define REG_FLASH_DATA	0xF4		/**< Flash data register */
+
+/* register value as seen by the driver <-> bus value, and the value
+ * returned by MREAD_D16/MREAD_D32 <-> bus value */
+#ifdef MAC_BYTESWAP
+# define REGVAL(v)		((u_int16)(v))
+# define MACVAL16(v)	((u_int16)OSS_SWAP16(v))
+# define MACVAL32(v)	((u_int32)OSS_SWAP32(v))
+#else
+# define REGVAL(v)		((u_int16)OSS_SWAP16(v))
+# define MACVAL16(v)	((u_int16)(v))
+# define MACVAL32(v)	((u_int32)(v))
+#endif
+
+/* flash state machine */
+#define FL_READ			0			/**< read array */
+#define FL_STATUS		1			/**< read status register */
+#define FL_PROG			2			/**< word program setup */
+#define FL_ERASE		3			/**< block erase setup */
+#define FL_LOCK			4			/**< lock bit setup */
+
+#define FL_SR_READY		0x80		/**< status: ready */
+#define FL_SR_ERASE		0x20		/**< status: erase error */
+#define FL_SR_PROG		0x10		/**< status: program error */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static u_int16 SimRd16(M199_SIM_HW *sim, u_int32 offs);
+static void SimWr16(M199_SIM_HW *sim, u_int32 offs, u_int16 val);
+static void SdramStuck(M199_SIM_HW *sim);
+static u_int32 Reg32(M199_SIM_HW *sim, u_int32 offs);
+static u_int16 FlashRd(M199_SIM_HW *sim);
+static void FlashWr(M199_SIM_HW *sim, u_int16 val);
+
+/******************************* M199_SimCreate *******************************/
+/** Create a simulated module
+ *
+ *  The SDRAM is cleared, the flash and USM EEPROM are erased and the
+ *  ID PROM holds a valid M199 ID.
+ *
+ *  \param flashSize  \IN  Flash size [bytes] (0: M199_SIM_FLASH_SIZE)
+ *  \param flashSect  \IN  Flash sector size [bytes] (0: M199_SIM_FLASH_SECT)
+ *
+ *  \return           Module or NULL if out of memory
+ ******************************************************************************/
+M199_SIM_HW *M199_SimCreate(u_int32 flashSize, u_int32 flashSect)
+{
+	M199_SIM_HW *sim;
+
+	if( (sim = (M199_SIM_HW*)calloc(1, sizeof(M199_SIM_HW))) == NULL )
+		return(NULL);
+
+	sim->flashSize = flashSize ? flashSize : M199_SIM_FLASH_SIZE;
+	sim->flashSect = flashSect ? flashSect : M199_SIM_FLASH_SECT;
+	sim->sdram = (u_int8*)calloc(1, M199_SIM_SDRAM_SIZE);
+	sim->flash = (u_int8*)malloc(sim->flashSize);
+	if( sim->sdram == NULL || sim->flash == NULL ){
+		M199_SimDestroy(sim);
+		return(NULL);
+	}
+	memset(sim->flash, 0xff, sim->flashSize);
+	memset(sim->usm, 0xff, sizeof(sim->usm));
+	sim->flashStatus = FL_SR_READY;
+
+	sim->id[0] = 0x5346;		/* magic */
+	sim->id[1] = 199;			/* module id */
+
+	return(sim);
+}
+
+/****************************** M199_SimDestroy *******************************/
+/** Free a simulated module
+ *
+ *  \param sim        \IN  Module
+ ******************************************************************************/
+void M199_SimDestroy(M199_SIM_HW *sim)
+{
+	if( sim == NULL )
+		return;
+	free(sim->sdram);
+	free(sim->flash);
+	free(sim);
+}
+
+/******************************* M199_SimCycles *******************************/
+/** Get and/or reset the bus cycle counters
+ *
+ *  \param sim        \IN  Module
+ *  \param cycP       \OUT Counters (may be NULL)
+ *  \param reset      \IN  TRUE: reset counters
+ ******************************************************************************/
+void M199_SimCycles(M199_SIM_HW *sim, M199_SIM_CYCLES *cycP, int32 reset)
+{
+	if( cycP )
+		*cycP = sim->cyc;
+	if( reset )
+		memset(&sim->cyc, 0, sizeof(sim->cyc));
+}
+
+/****************************** M199_SimIrqRaise ******************************/
+/** Set interrupt request bits
+ *
+ *  \param sim        \IN  Module
+ *  \param mask       \IN  Interrupt sources to set in the IRR
+ *
+ *  \return           TRUE if the module asserts its interrupt (IRR & IER)
+ ******************************************************************************/
+int32 M199_SimIrqRaise(M199_SIM_HW *sim, u_int32 mask)
+{
+	sim->irr |= mask;
+	return( (sim->irr & Reg32(sim, REG_IER)) != 0 );
+}
+
+/******************************** M199_SimMap *********************************/
+/** Map a physical address range of the A24 window (mmap() stand-in)
+ *
+ *  The window is at M199_SIM_PHYS_ADDR and is backed by the SDRAM array,
+ *  accesses through the mapping are not counted. Like the real window the
+ *  mapping holds the bytes in bus order, but the register block is not
+ *  decoded.
+ *
+ *  \param sim        \IN  Module
+ *  \param physAddr   \IN  Physical address
+ *  \param size       \IN  Size [bytes]
+ *
+ *  \return           Mapped address or NULL if outside of the window
+ ******************************************************************************/
+u_int8 *M199_SimMap(M199_SIM_HW *sim, u_int32 physAddr, u_int32 size)
+{
+	u_int32 offs = physAddr - M199_SIM_PHYS_ADDR;
+
+	if( physAddr < M199_SIM_PHYS_ADDR || offs > M199_SIM_SDRAM_SIZE ||
+		size > M199_SIM_SDRAM_SIZE - offs )
+		return(NULL);
+	return(sim->sdram + offs);
+}
+
+/******************************* M199_SimRead16 *******************************/
+/** D16 read cycle (MREAD_D16)
+ *
+ *  \param ma         \IN  Module (MACCESS)
+ *  \param offs       \IN  Offset
+ *
+ *  \return           Bus value
+ ******************************************************************************/
+u_int16 M199_SimRead16(void *ma, u_int32 offs)
+{
+	M199_SIM_HW *sim = (M199_SIM_HW*)ma;
+
+	u_int16 val;
+
+	sim->cyc.d16Rd++;
+	val = SimRd16(sim, offs);
+	return( MACVAL16(val) );
+}
+
+/****************************** M199_SimWrite16 *******************************/
+/** D16 write cycle (MWRITE_D16)
+ *
+ *  \param ma         \IN  Module (MACCESS)
+ *  \param offs       \IN  Offset
+ *  \param val        \IN  Bus value
+ ******************************************************************************/
+void M199_SimWrite16(void *ma, u_int32 offs, u_int16 val)
+{
+	M199_SIM_HW *sim = (M199_SIM_HW*)ma;
+
+	sim->cyc.d16Wr++;
+	SimWr16(sim, offs, MACVAL16(val));
+}
+
+/******************************* M199_SimRead32 *******************************/
+/** D32 read cycle (MREAD_D32)
+ *
+ *  A D32 access to registers behaves like two D16 accesses in host order.
+ *
+ *  \param ma         \IN  Module (MACCESS)
+ *  \param offs       \IN  Offset
+ *
+ *  \return           Bus value
+ ******************************************************************************/
+u_int32 M199_SimRead32(void *ma, u_int32 offs)
+{
+	M199_SIM_HW *sim = (M199_SIM_HW*)ma;
+	u_int16 w[2];
+	u_int32 val;
+
+	sim->cyc.d32Rd++;
+#ifdef M199_A24
+	offs &= M199_SIM_SDRAM_SIZE - 4;
+	if( offs + 4 <= M199_SIM_REG_A24 || offs >= M199_SIM_REG_SIZE ){
+		memcpy(&val, sim->sdram + offs, 4);
+		return( MACVAL32(val) );
+	}
+#endif
+	w[0] = SimRd16(sim, offs);
+	w[1] = SimRd16(sim, offs + 2);
+	memcpy(&val, w, 4);
+	return( MACVAL32(val) );
+}
+
+/****************************** M199_SimWrite32 *******************************/
+/** D32 write cycle (MWRITE_D32)
+ *
+ *  \param ma         \IN  Module (MACCESS)
+ *  \param offs       \IN  Offset
+ *  \param val        \IN  Bus value
+ ******************************************************************************/
+void M199_SimWrite32(void *ma, u_int32 offs, u_int32 val)
+{
+	M199_SIM_HW *sim = (M199_SIM_HW*)ma;
+	u_int16 w[2];
+
+	sim->cyc.d32Wr++;
+	val = MACVAL32(val);
+#ifdef M199_A24
+	offs &= M199_SIM_SDRAM_SIZE - 4;
+	if( offs + 4 <= M199_SIM_REG_A24 || offs >= M199_SIM_REG_SIZE ){
+		memcpy(sim->sdram + offs, &val, 4);
+		SdramStuck(sim);
+		return;
+	}
+#endif
+	memcpy(w, &val, 4);
+	SimWr16(sim, offs, w[0]);
+	SimWr16(sim, offs + 2, w[1]);
+}
+
+/*********************************** m_read ***********************************/
+/** Read ID PROM word (replaces the ID library)
+ *
+ *  \param base       \IN  Module (MACCESS)
+ *  \param index      \IN  Word index
+ *
+ *  \return           ID PROM word
+ ******************************************************************************/
+int m_read(U_INT32_OR_64 base, u_int8 index)
+{
+	M199_SIM_HW *sim = (M199_SIM_HW*)base;
+
+	sim->cyc.idRd++;
+	return( sim->id[index % M199_SIM_ID_SIZE] );
+}
+
+/********************************** usm_read **********************************/
+/** Read USM EEPROM word (replaces the ID library)
+ *
+ *  \param base       \IN  Module (MACCESS)
+ *  \param index      \IN  Word index
+ *
+ *  \return           USM EEPROM word
+ ******************************************************************************/
+int usm_read(U_INT32_OR_64 base, u_int8 index)
+{
+	M199_SIM_HW *sim = (M199_SIM_HW*)base;
+
+	sim->cyc.usmRd++;
+	return( sim->usm[index % M199_SIM_USM_SIZE] );
+}
+
+/********************************* usm_write **********************************/
+/** Write USM EEPROM word (replaces the ID library)
+ *
+ *  \param base       \IN  Module (MACCESS)
+ *  \param index      \IN  Word index
+ *  \param data       \IN  Data
+ *
+ *  \return           0
+ ******************************************************************************/
+int usm_write(u_int8 *base, u_int8 index, u_int16 data)
+{
+	M199_SIM_HW *sim = (M199_SIM_HW*)base;
+
+	sim->cyc.usmWr++;
+	sim->usm[index % M199_SIM_USM_SIZE] = data;
+	return(0);
+}
+
+/*********************************** SimRd16 **********************************/
+/** Decode a D16 read
+ *
+ *  \param sim        \IN  Module
+ *  \param offs       \IN  Offset
+ *
+ *  \return           Bus value
+ ******************************************************************************/
+static u_int16 SimRd16(M199_SIM_HW *sim, u_int32 offs)
+{
+	u_int16 val;
+
+	offs &= ~1;
+#ifdef M199_A24
+	offs &= M199_SIM_SDRAM_SIZE - 1;
+	if( offs < M199_SIM_REG_A24 || offs >= M199_SIM_REG_SIZE ){
+		memcpy(&val, sim->sdram + offs, 2);
+		return(val);
+	}
+#else
+	offs &= M199_SIM_REG_SIZE - 1;
+#endif
+
+	switch( offs ){
+		case REG_IRR:
+			return( REGVAL(sim->irr & 0xffff) );
+		case REG_IRR + 2:
+			return( REGVAL(sim->irr >> 16) );
+		case REG_SDRAM_DATA:
+			memcpy(&val, sim->sdram + sim->sdramAddr, 2);
+			sim->sdramAddr = (sim->sdramAddr + 2) & (M199_SIM_SDRAM_SIZE - 1);
+			return(val);
+		case REG_FLASH_DATA:
+			return( REGVAL(FlashRd(sim)) );
+		default:
+			return( sim->reg[offs/2] );
+	}
+}
+
+/*********************************** SimWr16 **********************************/
+/** Decode a D16 write
+ *
+ *  \param sim        \IN  Module
+ *  \param offs       \IN  Offset
+ *  \param val        \IN  Bus value
+ ******************************************************************************/
+static void SimWr16(M199_SIM_HW *sim, u_int32 offs, u_int16 val)
+{
+	offs &= ~1;
+#ifdef M199_A24
+	offs &= M199_SIM_SDRAM_SIZE - 1;
+	if( offs < M199_SIM_REG_A24 || offs >= M199_SIM_REG_SIZE ){
+		memcpy(sim->sdram + offs, &val, 2);
+		SdramStuck(sim);
+		return;
+	}
+#else
+	offs &= M199_SIM_REG_SIZE - 1;
+#endif
+
+	switch( offs ){
+		case REG_IRR:
+			sim->irr &= ~(u_int32)REGVAL(val);
+			break;
+		case REG_IRR + 2:
+			sim->irr &= ~((u_int32)REGVAL(val) << 16);
+			break;
+		case REG_SDRAM_ADDR:
+		case REG_SDRAM_ADDR + 2:
+			sim->reg[offs/2] = val;
+			sim->sdramAddr = Reg32(sim, REG_SDRAM_ADDR)
+				& (M199_SIM_SDRAM_SIZE - 2);
+			sim->cyc.sdramAddrWr++;
+			break;
+		case REG_SDRAM_DATA:
+			memcpy(sim->sdram + sim->sdramAddr, &val, 2);
+			SdramStuck(sim);
+			sim->sdramAddr = (sim->sdramAddr + 2) & (M199_SIM_SDRAM_SIZE - 1);
+			break;
+		case REG_FLASH_ADDR:
+		case REG_FLASH_ADDR + 2:
+			sim->reg[offs/2] = val;
+			sim->flashAddr = Reg32(sim, REG_FLASH_ADDR) % sim->flashSize;
+			sim->cyc.flashAddrWr++;
+			break;
+		case REG_FLASH_DATA:
+			FlashWr(sim, REGVAL(val));
+			break;
+		default:
+			sim->reg[offs/2] = val;
+	}
+}
+
+/********************************* SdramStuck *********************************/
+/** Apply the stuck SDRAM bits after a write
+ *
+ *  \param sim        \IN  Module
+ ******************************************************************************/
+static void SdramStuck(M199_SIM_HW *sim)
+{
+	if( sim->sdramStuckMask )
+		sim->sdram[sim->sdramStuckOffs % M199_SIM_SDRAM_SIZE] &=
+			(u_int8)~sim->sdramStuckMask;
+}
+
+/************************************ Reg32 ***********************************/
+/** Get value of a 32-bit register as written by the driver
+ *
+ *  \param sim        \IN  Module
+ *  \param offs       \IN  Register offset (low word)
+ *
+ *  \return           Register value
+ ******************************************************************************/
+static u_int32 Reg32(M199_SIM_HW *sim, u_int32 offs)
+{
+	return( (u_int32)REGVAL(sim->reg[offs/2]) |
+			((u_int32)REGVAL(sim->reg[offs/2 + 1]) << 16) );
+}
+
+/*********************************** FlashRd **********************************/
+/** Read the flash data register
+ *
+ *  \param sim        \IN  Module
+ *
+ *  \return           Flash word (first byte most significant) or status
+ ******************************************************************************/
+static u_int16 FlashRd(M199_SIM_HW *sim)
+{
+	u_int32 addr = sim->flashAddr & ~1;
+
+	if( sim->flashMode == FL_READ )
+		return( (u_int16)((sim->flash[addr] << 8) | sim->flash[addr + 1]) );
+
+	if( sim->flashBusy ){
+		sim->flashBusy--;
+		return( (u_int16)(sim->flashStatus & ~FL_SR_READY) );
+	}
+	return( sim->flashStatus );
+}
+
+/*********************************** FlashWr **********************************/
+/** Write the flash data register (command or program data)
+ *
+ *  \param sim        \IN  Module
+ *  \param val        \IN  Value
+ ******************************************************************************/
+static void FlashWr(M199_SIM_HW *sim, u_int16 val)
+{
+	u_int32 addr = sim->flashAddr & ~1;
+	u_int16 old;
+
+	switch( sim->flashMode ){
+		case FL_PROG:
+			/* programming can only clear bits */
+			old = (u_int16)((sim->flash[addr] << 8) | sim->flash[addr + 1]);
+			if( (old & val) != val )
+				sim->flashStatus |= FL_SR_PROG;
+			old &= val;
+			sim->flash[addr]     = (u_int8)(old >> 8);
+			sim->flash[addr + 1] = (u_int8)old;
+			sim->flashBusy = sim->flashBusyReads;
+			sim->flashMode = FL_STATUS;
+			return;
+		case FL_ERASE:
+			if( (val & 0xff) == 0xD0 ){
+				memset(sim->flash + (addr - (addr % sim->flashSect)), 0xff,
+					   sim->flashSect);
+				sim->flashBusy = sim->flashBusyReads;
+			}
+			else
+				sim->flashStatus |= FL_SR_ERASE | FL_SR_PROG;
+			sim->flashMode = FL_STATUS;
+			return;
+		case FL_LOCK:
+			/* lock bits are not modelled */
+			sim->flashMode = FL_STATUS;
+			return;
+	}
+
+	switch( val & 0xff ){
+		case 0xFF:	sim->flashMode = FL_READ;	break;
+		case 0x70:	sim->flashMode = FL_STATUS;	break;
+		case 0x50:	sim->flashStatus = FL_SR_READY;	break;
+		case 0x10:
+		case 0x40:	sim->flashMode = FL_PROG;	break;
+		case 0x20:	sim->flashMode = FL_ERASE;	break;
+		case 0x60:	sim->flashMode = FL_LOCK;	break;
+		default:	break;
+	}
+}
@@ -0,0 +1,366 @@
+/*********************  P r o g r a m  -  M o d u l e *************************/
+/*!
+ *        \file  m199_sim_env.c
+ *
+ *      \author  ck
+ *
+ *      \brief   User space OSS and DESC functions for the M199 simulator
+ *
+ *               Provides the OSS and DESC functions used by the driver,
+ *               so that the driver runs in a single threaded user space
+ *               program. Ticks are milliseconds of the real time clock.
+ *               Timers do not expire on their own: a semaphore wait that
+ *               would block first runs the started timer callbacks, which
+ *               may signal it. If it still would block, it returns
+ *               ERR_OSS_TIMEOUT, because there is nobody else to signal it.
+ *               An endless wait that would block is a deadlock of the
+ *               driver and aborts. Spin locks are no-ops.
+ *
+ *               The descriptor is an M199_SIM_DESC key list.
+ *
+ *     Required: -
+ *     \switches (none)
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2007-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <MEN/men_typs.h>
+#include <MEN/oss.h>
+#include <MEN/desc.h>
+#include <MEN/mdis_err.h>
+#include <MEN/m199_sim.h>
+
+/*--------------------------------------+
+|   TYPDEFS                             |
++--------------------------------------*/
+/** semaphore */
+typedef struct {
+	int32	type;						/**< OSS_SEM_BIN/OSS_SEM_COUNT */
+	int32	count;						/**< current value */
+}SIM_SEM;
+
+/** signal */
+typedef struct {
+	int32	sigNo;						/**< signal number */
+	u_int32	sent;						/**< number of sent signals */
+}SIM_SIG;
+
+/** timer */
+typedef struct {
+	void	(*funct)(void *arg);		/**< callback */
+	void	*arg;						/**< callback argument */
+	int32	started;					/**< timer started */
+}SIM_TIMER;
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define SIM_TIMER_MAX		8			/**< max. number of timers */
+#define SIM_TIMER_PASSES	1000		/**< max. timer runs per wait */
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static SIM_TIMER *G_timer[SIM_TIMER_MAX];
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int32 SimTimerRun(void);
+
+/*********************************** OSS_xxx **********************************/
+/* memory */
+void *OSS_MemGet(OSS_HANDLE *osHdl, u_int32 size, u_int32 *gotsizeP)
+{
+	*gotsizeP = size;
+	return( calloc(1, size) );
+}
+
+int32 OSS_MemFree(OSS_HANDLE *osHdl, void *addr, u_int32 size)
+{
+	free(addr);
+	return(0);
+}
+
+void OSS_MemFill(OSS_HANDLE *osHdl, u_int32 size, char *adr, int8 value)
+{
+	memset(adr, value, size);
+}
+
+void OSS_MemCopy(OSS_HANDLE *osHdl, u_int32 size, char *src, char *dest)
+{
+	memmove(dest, src, size);
+}
+
+/* time */
+int32 OSS_Delay(OSS_HANDLE *osHdl, int32 msec)
+{
+	usleep(msec * 1000);
+	return(msec);
+}
+
+void OSS_MikroDelay(OSS_HANDLE *osHdl, u_int32 usec)
+{
+	usleep(usec);
+}
+
+u_int32 OSS_TickGet(OSS_HANDLE *osHdl)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return( (u_int32)(tv.tv_sec * 1000 + tv.tv_usec / 1000) );
+}
+
+int32 OSS_TickRateGet(OSS_HANDLE *osHdl)
+{
+	return(1000);
+}
+
+char *OSS_Ident(void)
+{
+	return("OSS (M199 simulator)");
+}
+
+/* interrupts: the interrupt routine is called by the simulator program */
+OSS_IRQ_STATE OSS_IrqMaskR(OSS_HANDLE *osHdl, OSS_IRQ_HANDLE *irqHdl)
+{
+	return(0);
+}
+
+void OSS_IrqRestore(OSS_HANDLE *osHdl, OSS_IRQ_HANDLE *irqHdl,
+					OSS_IRQ_STATE oldState)
+{
+}
+
+/* semaphores */
+int32 OSS_SemCreate(OSS_HANDLE *osHdl, int32 semType, int32 initVal,
+					OSS_SEM_HANDLE **semP)
+{
+	SIM_SEM *sem;
+
+	if( (sem = (SIM_SEM*)calloc(1, sizeof(SIM_SEM))) == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+	sem->type  = semType;
+	sem->count = initVal;
+	*semP = (OSS_SEM_HANDLE*)sem;
+	return(0);
+}
+
+int32 OSS_SemRemove(OSS_HANDLE *osHdl, OSS_SEM_HANDLE **semP)
+{
+	free(*semP);
+	*semP = NULL;
+	return(0);
+}
+
+int32 OSS_SemWait(OSS_HANDLE *osHdl, OSS_SEM_HANDLE *semHdl, int32 msec)
+{
+	SIM_SEM *sem = (SIM_SEM*)semHdl;
+
+	int32 pass;
+
+	/* let the started timers signal the semaphore */
+	for (pass = 0; sem->count == 0 && msec != OSS_SEM_NOWAIT &&
+			 pass < SIM_TIMER_PASSES; pass++){
+		if( !SimTimerRun() )
+			break;
+	}
+	if( sem->count > 0 ){
+		sem->count--;
+		return(0);
+	}
+	if( msec == OSS_SEM_WAITFOREVER ){
+		fprintf(stderr, "*** OSS_SemWait: deadlock\n");
+		abort();
+	}
+	if( msec > 0 )
+		OSS_Delay(osHdl, msec);
+	return(ERR_OSS_TIMEOUT);
+}
+
+int32 OSS_SemSignal(OSS_HANDLE *osHdl, OSS_SEM_HANDLE *semHdl)
+{
+	SIM_SEM *sem = (SIM_SEM*)semHdl;
+
+	if( sem->type == OSS_SEM_BIN )
+		sem->count = 1;
+	else
+		sem->count++;
+	return(0);
+}
+
+/* signals */
+int32 OSS_SigCreate(OSS_HANDLE *osHdl, int32 value, OSS_SIG_HANDLE **sigP)
+{
+	SIM_SIG *sig;
+
+	if( (sig = (SIM_SIG*)calloc(1, sizeof(SIM_SIG))) == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+	sig->sigNo = value;
+	*sigP = (OSS_SIG_HANDLE*)sig;
+	return(0);
+}
+
+int32 OSS_SigSend(OSS_HANDLE *osHdl, OSS_SIG_HANDLE *sigHdl)
+{
+	((SIM_SIG*)sigHdl)->sent++;
+	return(0);
+}
+
+int32 OSS_SigRemove(OSS_HANDLE *osHdl, OSS_SIG_HANDLE **sigP)
+{
+	free(*sigP);
+	*sigP = NULL;
+	return(0);
+}
+
+/* spin locks: single threaded */
+int32 OSS_SpinLockCreate(OSS_HANDLE *osHdl, OSS_SPINL_HANDLE **spinlP)
+{
+	*spinlP = (OSS_SPINL_HANDLE*)osHdl;
+	return(0);
+}
+
+int32 OSS_SpinLockRemove(OSS_HANDLE *osHdl, OSS_SPINL_HANDLE **spinlP)
+{
+	*spinlP = NULL;
+	return(0);
+}
+
+int32 OSS_SpinLockAcquire(OSS_HANDLE *osHdl, OSS_SPINL_HANDLE *spinlHdl)
+{
+	return(0);
+}
+
+int32 OSS_SpinLockRelease(OSS_HANDLE *osHdl, OSS_SPINL_HANDLE *spinlHdl)
+{
+	return(0);
+}
+
+/* timers: the callbacks are run by OSS_SemWait */
+int32 OSS_TimerCreate(OSS_HANDLE *osHdl, void (*funct)(void *arg), void *arg,
+					  OSS_TIMER_HANDLE **timerP)
+{
+	SIM_TIMER *tim;
+	int32 i;
+
+	for (i = 0; i < SIM_TIMER_MAX && G_timer[i]; i++)
+		;
+	if( i == SIM_TIMER_MAX ||
+		(tim = (SIM_TIMER*)calloc(1, sizeof(SIM_TIMER))) == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+	tim->funct = funct;
+	tim->arg   = arg;
+	G_timer[i] = tim;
+	*timerP = (OSS_TIMER_HANDLE*)tim;
+	return(0);
+}
+
+int32 OSS_TimerRemove(OSS_HANDLE *osHdl, OSS_TIMER_HANDLE **timerP)
+{
+	int32 i;
+
+	for (i = 0; i < SIM_TIMER_MAX; i++)
+		if( G_timer[i] == (SIM_TIMER*)*timerP )
+			G_timer[i] = NULL;
+	free(*timerP);
+	*timerP = NULL;
+	return(0);
+}
+
+int32 OSS_TimerStart(OSS_HANDLE *osHdl, OSS_TIMER_HANDLE *timerHdl,
+					 int32 msec, int32 cyclic)
+{
+	((SIM_TIMER*)timerHdl)->started = TRUE;
+	return(0);
+}
+
+int32 OSS_TimerStop(OSS_HANDLE *osHdl, OSS_TIMER_HANDLE *timerHdl)
+{
+	((SIM_TIMER*)timerHdl)->started = FALSE;
+	return(0);
+}
+
+/******************************** SimTimerRun *********************************/
+/** Run the callbacks of the started timers once, returns number of runs */
+static int32 SimTimerRun(void)
+{
+	int32 i, n = 0;
+
+	for (i = 0; i < SIM_TIMER_MAX; i++){
+		if( G_timer[i] && G_timer[i]->started ){
+			G_timer[i]->started = FALSE;
+			G_timer[i]->funct(G_timer[i]->arg);
+			n++;
+		}
+	}
+	return(n);
+}
+
+/********************************** DESC_xxx **********************************/
+int32 DESC_Init(DESC_SPEC *descSpec, OSS_HANDLE *osHdl, DESC_HANDLE **descP)
+{
+	*descP = (DESC_HANDLE*)descSpec;
+	return(0);
+}
+
+int32 DESC_GetUInt32(DESC_HANDLE *descHdl, u_int32 defVal, u_int32 *valueP,
+					 char *keyFmt, ...)
+{
+	M199_SIM_DESC *desc = (M199_SIM_DESC*)descHdl;
+	char key[64];
+	va_list ap;
+
+	va_start(ap, keyFmt);
+	vsnprintf(key, sizeof(key), keyFmt, ap);
+	va_end(ap);
+
+	for ( ; desc && desc->key; desc++){
+		if( strcmp(desc->key, key) == 0 ){
+			*valueP = desc->val;
+			return(0);
+		}
+	}
+	*valueP = defVal;
+	return(ERR_DESC_KEY_NOTFOUND);
+}
+
+int32 DESC_Exit(DESC_HANDLE **descP)
+{
+	*descP = NULL;
+	return(0);
+}
+
+int32 DESC_DbgLevelSet(DESC_HANDLE *descHdl, u_int32 dbgLevel)
+{
+	return(0);
+}
+
+char *DESC_Ident(void)
+{
+	return("DESC (M199 simulator)");
+}
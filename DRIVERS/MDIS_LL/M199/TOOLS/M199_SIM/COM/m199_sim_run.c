@@ -0,0 +1,1424 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   M199_SIM_HW                         ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file m199_sim_run.c
+ *       \author ck
+ *
+ *       \brief  Runs the M199 driver against the register-level simulator
+ *
+ *               Calls the driver through its LL entry table, checks the
+ *               transferred data against the model and prints the bus
+ *               cycles and time of each operation (addr: SDRAM and flash
+ *               address register writes, eeprom: ID PROM and USM EEPROM
+ *               words). The exit code is the
+ *               number of failed operations, so the program can be used
+ *               for regression tests without hardware.
+ *
+ *               The M199 client library is tested against the simulator
+ *               as well: M_open(), M_getstat(), M_setstat() etc. are
+ *               replaced by functions that call the driver directly.
+ *
+ *     Required: libraries: usr_utl, m199_api
+ *     \switches M199_SIM, M199_A24, MAC_BYTESWAP, _LL_DRV_
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2007-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <MEN/men_typs.h>
+#include <MEN/usr_utl.h>
+#include <MEN/oss.h>
+#include <MEN/desc.h>
+#include <MEN/mdis_api.h>
+#include <MEN/mdis_err.h>
+#include <MEN/ll_defs.h>
+#include <MEN/m199_sim.h>
+#include <MEN/ll_entry.h>
+#include <MEN/m199_drv.h>
+#include <MEN/m199_api.h>
+
+static const char IdentString[]=MENT_XSTR(MAK_REVISION);
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define SDRAM_OFFS		0x100002	/**< SDRAM test offset (not D32 aligned) */
+#define FLASH_SECT		0x20000		/**< flash sector size [bytes] */
+#define CH_NUM			2			/**< SDRAM channels (equal parts) */
+#define CH_SIZE			(M199_SIM_SDRAM_SIZE / CH_NUM) /**< channel size */
+#define FC_OFFS			0x200000	/**< fill/copy test area */
+#define FC_SIZE			0x4000		/**< fill/copy test area size [bytes] */
+#define AS_NUM			4			/**< async transfers per direction */
+#define AS_SIZE			0x400		/**< async transfer size [bytes] */
+#define AS_BIG			0x2000		/**< async transfer of several chunks */
+#define AS_STUCK		(FC_OFFS + AS_BIG - 0x11) /**< byte with stuck bit */
+#define AS_HUGE			0x400000	/**< async transfer of more chunks
+											 than timer runs per wait */
+#define SG_WRAP_NUM		(0x80000000 / (CH_SIZE / 2)) /**< segments of CH_SIZE
+												 summing up to 4GB */
+#define API_PATH		1			/**< MDIS path of the client library */
+#define API_SIZE		(3 * M199API_BUF_MIN + 2) /**< client library transfer
+												 of several chunks [bytes] */
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static M199_SIM_HW			*G_sim;
+static LL_ENTRY			G_entry;
+static LL_HANDLE		*G_llHdl;
+static struct timeval	G_start;
+static int				G_failed;
+static int32			G_apiCh;		/**< current channel of API_PATH */
+static int32			G_apiErrno;		/**< error of the last M_xxx call */
+
+static M199_SIM_DESC G_desc[] = {
+	{ "ID_CHECK",			1 },
+	{ "FLASH_SECT_SIZE",	FLASH_SECT },
+	{ "SDRAM_CH_NUM",		CH_NUM },
+#ifndef M199_A24
+	{ "CHANNEL_0/USER_REG",	0x60 },		/* channel 1 has no register */
+	{ "CHANNEL_0/USER_WIDTH", 4 },
+#else
+	{ "SDRAM_PHYS_ADDR",	M199_SIM_PHYS_ADDR },
+#endif
+	{ NULL,					0 }
+};
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void OpStart(void);
+static void OpEnd(const char *name, int32 err, int ok);
+static int32 GetBlk(int32 code, void *data, u_int32 size);
+static int32 SetBlk(int32 code, void *data, u_int32 size);
+static void TestSdram(u_int32 size);
+static void TestChannel(void);
+static void TestMap(void);
+static void TestMemTest(void);
+static void TestFillCopy(void);
+static void FcCheck(const char *name, M199_SDRAM_ACCESS *acc, u_int16 *ref);
+static void TestCheck(void);
+static void TestVerify(void);
+static void TestAsync(void);
+static void TestAsyncChunk(void);
+static void TestAsyncQueue(void);
+static void TestCmdList(void);
+static void TestUserReg(void);
+static void TestRegWait(void);
+static void TestReadWrite(void);
+static void TestUsm(void);
+static void TestFlash(void);
+static void TestIrq(void);
+static void TestStats(u_int32 size);
+static void TestApi(void);
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          number of failed operations
+ */
+int main(int argc, char *argv[])
+{
+	MACCESS	ma[1];
+	char	*str, errbuf[40];
+	u_int32	size, busy;
+	int32	err;
+
+	if ((str = UTL_ILLIOPT("s=b=h?", errbuf)))
+	{
+		printf( "*** ERROR: %s\n", str);
+		return(1);
+	}
+	if ((UTL_TSTOPT("?")) || (UTL_TSTOPT("h"))) {
+		printf("Syntax: m199_sim [<options>]\n");
+		printf("Function: run the M199 driver against the register model\n");
+		printf("Options:\n");
+		printf("  -s=<bytes>   SDRAM transfer size............. [0x10000]\n");
+		printf("  -b=<reads>   flash busy status reads......... [0]      \n");
+		printf("  -? / -h      prints this help................ [no]      \n");
+		printf("%s\n", IdentString );
+		printf("\n");
+		return(1);
+	}
+	size = (str = UTL_TSTOPT("s=")) ? strtoul(str, NULL, 0) : 0x10000;
+	busy = (str = UTL_TSTOPT("b=")) ? strtoul(str, NULL, 0) : 0;
+	size &= ~1;
+	if( size == 0 || SDRAM_OFFS + size > CH_SIZE ){
+		printf("*** illegal size 0x%lx\n", (unsigned long)size);
+		return(1);
+	}
+
+	if( (G_sim = M199_SimCreate(0, FLASH_SECT)) == NULL ){
+		printf("*** can't create simulator\n");
+		return(1);
+	}
+	G_sim->flashBusyReads = busy;
+
+	M199_GetEntry(&G_entry);
+	ma[0] = G_sim;
+
+	printf("%-26s %8s %8s %8s %8s %6s %6s %9s\n", "operation",
+		   "D16 rd", "D16 wr", "D32 rd", "D32 wr", "addr", "eeprom",
+		   "time[us]");
+
+	OpStart();
+	err = G_entry.init(G_desc, NULL, ma, NULL, NULL, &G_llHdl);
+	OpEnd("init", err, TRUE);
+	if( err )
+		goto abort;
+
+	TestSdram(size);
+	TestChannel();
+	TestMap();
+	TestMemTest();
+	TestFillCopy();
+	TestCheck();
+	TestVerify();
+	TestAsync();
+	TestAsyncChunk();
+	TestAsyncQueue();
+	TestCmdList();
+	TestUserReg();
+	TestRegWait();
+	TestReadWrite();
+	TestUsm();
+	TestFlash();
+	TestIrq();
+	TestStats(size);
+	TestApi();
+
+	OpStart();
+	err = G_entry.exit(&G_llHdl);
+	OpEnd("exit", err, TRUE);
+
+abort:
+	M199_SimDestroy(G_sim);
+	printf("%d operation(s) failed\n", G_failed);
+	return(G_failed);
+}
+
+/********************************* TestSdram ********************************/
+/** SDRAM transfers
+ *
+ *  \param size       \IN  transfer size [bytes]
+ */
+static void TestSdram(u_int32 size)
+{
+	M199_SDRAM_ACCESS *acc;
+	M199_SDRAM_SG *sg, *wrap = NULL;
+	u_int16 *ref, *buf;
+	u_int32 n, nWords = size / 2, blkSize = M199_SDRAM_ACCESS_MINSIZE + size;
+	int32 err, nbr;
+
+	acc = (M199_SDRAM_ACCESS*)malloc(blkSize);
+	sg  = (M199_SDRAM_SG*)malloc(M199_SDRAM_SG_HDRSIZE(3) + size);
+	ref = (u_int16*)malloc(size);
+	buf = (u_int16*)malloc(size);
+	if( !acc || !sg || !ref || !buf ){
+		OpEnd("sdram alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		goto cleanup;
+	}
+	for (n = 0; n < nWords; n++)
+		ref[n] = (u_int16)(n * 0x0103 + 0x5a);
+
+	/* setstat/getstat */
+	acc->offset = SDRAM_OFFS;
+	acc->size   = size;
+	memcpy(acc->buf, ref, size);
+	OpStart();
+	err = SetBlk(M199_BLK_SDRAM, acc, blkSize);
+	OpEnd("sdram setstat", err, TRUE);
+
+	memset(acc->buf, 0, size);
+	OpStart();
+	err = GetBlk(M199_BLK_SDRAM, acc, blkSize);
+	OpEnd("sdram getstat", err, !memcmp(acc->buf, ref, size));
+
+	/* block i/o */
+	G_entry.setStat(G_llHdl, M199_SDRAM_POS, 0, SDRAM_OFFS);
+	for (n = 0; n < nWords; n++)
+		ref[n] = (u_int16)~ref[n];
+	OpStart();
+	err = G_entry.blockWrite(G_llHdl, 0, ref, size, &nbr);
+	OpEnd("block write", err, nbr == (int32)size);
+
+	G_entry.setStat(G_llHdl, M199_SDRAM_POS, 0, SDRAM_OFFS);
+	memset(buf, 0, size);
+	OpStart();
+	err = G_entry.blockRead(G_llHdl, 0, buf, size, &nbr);
+	OpEnd("block read", err, nbr == (int32)size && !memcmp(buf, ref, size));
+
+	/* three consecutive segments */
+	sg->segNum = 3;
+	sg->seg[0].offset = SDRAM_OFFS;
+	sg->seg[0].size   = (size / 4) & ~1;
+	sg->seg[1].offset = SDRAM_OFFS + sg->seg[0].size;
+	sg->seg[1].size   = (size / 2) & ~1;
+	sg->seg[2].offset = sg->seg[1].offset + sg->seg[1].size;
+	sg->seg[2].size   = size - sg->seg[0].size - sg->seg[1].size;
+	memset(M199_SDRAM_SG_DATA(sg), 0, size);
+	OpStart();
+	err = GetBlk(M199_BLK_SDRAM_SG, sg, M199_SDRAM_SG_HDRSIZE(3) + size);
+	OpEnd("sdram sg read (3 seg)", err,
+		  !memcmp(M199_SDRAM_SG_DATA(sg), ref, size));
+
+	/* segment sizes summing up to 4GB (wraps to 0) without any data */
+	wrap = (M199_SDRAM_SG*)malloc(M199_SDRAM_SG_HDRSIZE(SG_WRAP_NUM));
+	if( !wrap ){
+		OpEnd("sdram alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		goto cleanup;
+	}
+	wrap->segNum = SG_WRAP_NUM;
+	for (n = 0; n < SG_WRAP_NUM; n++){
+		wrap->seg[n].offset = 0;
+		wrap->seg[n].size   = CH_SIZE;
+	}
+	OpStart();
+	err = GetBlk(M199_BLK_SDRAM_SG, wrap, M199_SDRAM_SG_HDRSIZE(SG_WRAP_NUM));
+	OpEnd("sdram sg size wrap", 0, err == ERR_LL_USERBUF);
+
+cleanup:
+	free(acc);
+	free(sg);
+	free(wrap);
+	free(ref);
+	free(buf);
+}
+
+/******************************** TestChannel *******************************/
+/** SDRAM channels: offsets are relative to the channel area and
+ *  accesses beyond it are rejected
+ */
+static void TestChannel(void)
+{
+	M199_SDRAM_ACCESS acc;
+	M_SG_BLOCK blk;
+	u_int16 val = 0x1234;
+	int32 err, nbr, pos = 0;
+
+	acc.offset = 0x10;
+	acc.size   = 2;
+	acc.buf[0] = 0xa55a;
+	blk.data   = &acc;
+	blk.size   = M199_SDRAM_ACCESS_MINSIZE + acc.size;
+	OpStart();
+	err = G_entry.setStat(G_llHdl, M199_BLK_SDRAM, 1, (INT32_OR_64)&blk);
+	OpEnd("channel 1 setstat", err,
+		  G_sim->sdram[0x10] == 0 && G_sim->sdram[CH_SIZE + 0x10] != 0);
+
+	acc.buf[0] = 0;
+	OpStart();
+	err = G_entry.getStat(G_llHdl, M199_BLK_SDRAM, 1, (INT32_OR_64*)&blk);
+	OpEnd("channel 1 getstat", err, acc.buf[0] == 0xa55a);
+
+	acc.offset = CH_SIZE - 2;
+	acc.size   = 4;
+	blk.size   = M199_SDRAM_ACCESS_MINSIZE + acc.size;
+	OpStart();
+	err = G_entry.getStat(G_llHdl, M199_BLK_SDRAM, 1, (INT32_OR_64*)&blk);
+	OpEnd("channel 1 beyond end", err == ERR_LL_ILL_PARAM ? 0 : err, TRUE);
+
+	G_entry.setStat(G_llHdl, M199_SDRAM_POS, 1, CH_SIZE - 2);
+	OpStart();
+	err = G_entry.blockWrite(G_llHdl, 1, &val, sizeof(val), &nbr);
+	if( !err )
+		err = G_entry.blockWrite(G_llHdl, 1, &val, sizeof(val), &nbr);
+	G_entry.getStat(G_llHdl, M199_SDRAM_POS, 1, (INT32_OR_64*)&pos);
+	OpEnd("channel 1 block write end", err, nbr == 0 && pos == CH_SIZE);
+}
+
+/********************************** TestMap *********************************/
+/** SDRAM window mapping (A24): the mapped channel area and the driver
+ *  access the same data
+ */
+static void TestMap(void)
+{
+	M199_SDRAM_MAP map;
+	M199_SDRAM_ACCESS acc;
+	M_SG_BLOCK blk;
+	u_int8 *p = NULL;
+	int32 err, ok;
+
+	memset(&map, 0, sizeof(map));
+	blk.data = &map;
+	blk.size = sizeof(map);
+	OpStart();
+	err = G_entry.getStat(G_llHdl, M199_BLK_SDRAM_MAP, 1, (INT32_OR_64*)&blk);
+#ifdef M199_A24
+	if( !err )
+		p = M199_SimMap(G_sim, map.physAddr, map.size);
+	ok = (map.physAddr == M199_SIM_PHYS_ADDR + CH_SIZE &&
+		  map.offset == CH_SIZE && map.size == CH_SIZE && p != NULL);
+#else
+	ok  = (err == ERR_LL_ILL_FUNC);
+	err = 0;
+#endif
+	OpEnd("sdram map", err, ok);
+	if( p == NULL )
+		return;
+
+	/* written through the mapping, read and written back by the driver */
+	p[0x20] = 0x12;
+	p[0x21] = 0x34;
+	p[0x22] = 0x56;
+	p[0x23] = 0x78;
+	acc.offset = 0x20;
+	acc.size   = 4;
+	blk.data   = &acc;
+	blk.size   = M199_SDRAM_ACCESS_MINSIZE + acc.size;
+	OpStart();
+	err = G_entry.getStat(G_llHdl, M199_BLK_SDRAM, 1, (INT32_OR_64*)&blk);
+	if( !err ){
+		acc.offset = 0x40;
+		err = G_entry.setStat(G_llHdl, M199_BLK_SDRAM, 1, (INT32_OR_64)&blk);
+	}
+	OpEnd("sdram map access", err,
+		  (acc.buf[0] == 0x1234 || acc.buf[0] == 0x3412) &&
+		  !memcmp(p + 0x40, p + 0x20, 4));
+}
+
+/******************************** TestMemTest *******************************/
+/** In-driver SDRAM memory test
+ */
+static void TestMemTest(void)
+{
+	M199_SDRAM_TEST t;
+	M_SG_BLOCK blk;
+	int32 err;
+
+	OSS_MemFill(NULL, sizeof(t), (char*)&t, 0);
+	t.offset = 0x100;
+	t.size   = 0x4000;
+	t.tests  = M199_SDRAM_TEST_ALL;
+	t.seed   = 0x1999;
+	blk.data = &t;
+	blk.size = sizeof(t);
+	OpStart();
+	err = G_entry.getStat(G_llHdl, M199_BLK_SDRAM_TEST, 1, (INT32_OR_64*)&blk);
+	OpEnd("memory test", err, t.errCount == 0 && t.errTests == 0);
+
+	t.offset = CH_SIZE - 0x100;
+	t.size   = 0x200;
+	OpStart();
+	err = G_entry.getStat(G_llHdl, M199_BLK_SDRAM_TEST, 1, (INT32_OR_64*)&blk);
+	OpEnd("memory test beyond end", err == ERR_LL_ILL_PARAM ? 0 : err, TRUE);
+}
+
+/******************************** TestFillCopy ******************************/
+/** SDRAM fill and copy, checked against a reference copy of the area
+ */
+static void TestFillCopy(void)
+{
+	static const struct {
+		const char *name;
+		u_int32 src, dst, size;
+	} copy[] = {
+		{ "sdram copy up (D16)",	0x0000, 0x0006, 0x1802 },
+		{ "sdram copy up",			0x0800, 0x1004, 0x1802 },
+		{ "sdram copy down",		0x2002, 0x1f06, 0x1402 },
+	};
+	M199_SDRAM_ACCESS *acc;
+	M199_SDRAM_FILL fill;
+	M199_SDRAM_COPY cp;
+	u_int16 *ref, *patP;
+	u_int32 n, blkSize = M199_SDRAM_ACCESS_MINSIZE + FC_SIZE;
+	int32 err;
+
+	acc = (M199_SDRAM_ACCESS*)malloc(blkSize);
+	ref = (u_int16*)malloc(FC_SIZE);
+	if( !acc || !ref ){
+		OpEnd("fill/copy alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		goto cleanup;
+	}
+	for (n = 0; n < FC_SIZE/2; n++)
+		ref[n] = (u_int16)(n * 0x0305 + 0x11);
+	acc->offset = FC_OFFS;
+	acc->size   = FC_SIZE;
+	memcpy(acc->buf, ref, FC_SIZE);
+	SetBlk(M199_BLK_SDRAM, acc, blkSize);
+
+	/* 32-bit pattern from an unaligned offset */
+	fill.offset  = FC_OFFS + 0x102;
+	fill.size    = 0x1006;
+	fill.pattern = 0x12345678;
+	fill.width   = 4;
+	patP = (u_int16*)&fill.pattern;
+	for (n = 0; n < fill.size/2; n++)
+		ref[0x102/2 + n] = patP[n & 1];
+	OpStart();
+	err = SetBlk(M199_BLK_SDRAM_FILL, &fill, sizeof(fill));
+	OpEnd("sdram fill", err, TRUE);
+	FcCheck("sdram fill", acc, ref);
+
+	for (n = 0; n < sizeof(copy)/sizeof(copy[0]); n++){
+		cp.srcOffset = FC_OFFS + copy[n].src;
+		cp.dstOffset = FC_OFFS + copy[n].dst;
+		cp.size      = copy[n].size;
+		memmove(&ref[copy[n].dst/2], &ref[copy[n].src/2], copy[n].size);
+		OpStart();
+		err = SetBlk(M199_BLK_SDRAM_COPY, &cp, sizeof(cp));
+		OpEnd(copy[n].name, err, TRUE);
+		FcCheck(copy[n].name, acc, ref);
+	}
+
+	cp.srcOffset = 0;
+	cp.dstOffset = CH_SIZE - 0x100;
+	cp.size      = 0x200;
+	OpStart();
+	err = SetBlk(M199_BLK_SDRAM_COPY, &cp, sizeof(cp));
+	OpEnd("sdram copy beyond end", err == ERR_LL_ILL_PARAM ? 0 : err, TRUE);
+
+cleanup:
+	free(acc);
+	free(ref);
+}
+
+/********************************** FcCheck *********************************/
+/** Compare the fill/copy test area with its reference, after the bus
+ *  cycles of the operation were reported
+ *
+ *  \param name       \IN  operation name
+ *  \param acc        \IN  read buffer for the area
+ *  \param ref        \IN  expected area contents
+ */
+static void FcCheck(const char *name, M199_SDRAM_ACCESS *acc, u_int16 *ref)
+{
+	acc->offset = FC_OFFS;
+	acc->size   = FC_SIZE;
+	if( GetBlk(M199_BLK_SDRAM, acc, M199_SDRAM_ACCESS_MINSIZE + FC_SIZE) ||
+		memcmp(acc->buf, ref, FC_SIZE) ){
+		printf("%-26s  *** data mismatch\n", name);
+		G_failed++;
+	}
+}
+
+/********************************* TestCheck ********************************/
+/** SDRAM checksum, min/max and search, checked against the results
+ *  computed from the written data
+ */
+static void TestCheck(void)
+{
+	M199_SDRAM_ACCESS *acc;
+	M199_SDRAM_CHECK chk;
+	M199_SDRAM_FIND find;
+	u_int32 n, b, crc = 0xffffffff, sum = 0, nWords = FC_SIZE / 2;
+	u_int32 blkSize = M199_SDRAM_ACCESS_MINSIZE + FC_SIZE;
+	int32 err, val, sSum = 0, sMin = 0x7fff, sMax = -0x8000;
+	int32 uMin = 0xffff, uMax = 0;
+	u_int16 *data;
+	u_int8 *p;
+
+	if( (acc = (M199_SDRAM_ACCESS*)malloc(blkSize)) == NULL ){
+		OpEnd("check alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		return;
+	}
+	/* only the search marker has bit 15 set */
+	data = acc->buf;
+	for (n = 0; n < nWords; n++)
+		data[n] = (u_int16)((n * 0x1f3d + 0x7001) & 0x7fff);
+	data[nWords - 3] = 0xfedc;
+	acc->offset = FC_OFFS;
+	acc->size   = FC_SIZE;
+	SetBlk(M199_BLK_SDRAM, acc, blkSize);
+
+	for (n = 0; n < nWords; n++){
+		val   = (int16)data[n];
+		sum  += data[n];
+		sSum += val;
+		if( val < sMin )
+			sMin = val;
+		if( val > sMax )
+			sMax = val;
+		if( data[n] < uMin )
+			uMin = data[n];
+		if( data[n] > uMax )
+			uMax = data[n];
+	}
+	p = (u_int8*)data;
+	for (n = 0; n < FC_SIZE; n++){
+		crc ^= p[n];
+		for (b = 0; b < 8; b++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+	}
+	crc = ~crc;
+
+	chk.offset = FC_OFFS;
+	chk.size   = FC_SIZE;
+	chk.flags  = M199_SDRAM_CHECK_CRC;
+	OpStart();
+	err = GetBlk(M199_BLK_SDRAM_CHECK, &chk, sizeof(chk));
+	OpEnd("sdram check crc", err, chk.crc == crc && chk.sumLo == sum &&
+		  chk.sumHi == 0 && chk.min == uMin && chk.max == uMax);
+
+	chk.flags  = M199_SDRAM_CHECK_SIGNED;
+	OpStart();
+	err = GetBlk(M199_BLK_SDRAM_CHECK, &chk, sizeof(chk));
+	OpEnd("sdram check signed", err, chk.crc == 0 &&
+		  chk.sumLo == (u_int32)sSum &&
+		  chk.sumHi == (sSum < 0 ? 0xffffffff : 0) &&
+		  chk.min == sMin && chk.max == sMax);
+
+	find.offset = FC_OFFS + 2;
+	find.size   = FC_SIZE - 2;
+	find.value  = 0xfe00;
+	find.mask   = 0xff00;
+	OpStart();
+	err = GetBlk(M199_BLK_SDRAM_FIND, &find, sizeof(find));
+	OpEnd("sdram find", err, find.found &&
+		  find.foundOffset == FC_OFFS + (nWords - 3) * 2);
+
+	find.size   = (nWords - 4) * 2;
+	OpStart();
+	err = GetBlk(M199_BLK_SDRAM_FIND, &find, sizeof(find));
+	OpEnd("sdram find (no match)", err, !find.found);
+
+	free(acc);
+}
+
+/******************************** TestVerify ********************************/
+/** Verified SDRAM writes
+ */
+static void TestVerify(void)
+{
+	M199_SDRAM_ACCESS acc;
+	M199_VERIFY_STAT vs;
+	u_int32 n, blkSize = sizeof(acc);
+	int32 err, nbr, mode = 0;
+
+	for (n = 0; n < M199_SDRAM_BUFFER_SIZE; n++)
+		acc.buf[n] = (u_int16)(n * 0x0d0b);
+	acc.offset = FC_OFFS + 2;
+	acc.size   = M199_SDRAM_BUFFER_SIZE * 2;
+
+	G_entry.setStat(G_llHdl, M199_SDRAM_VERIFY, 0, TRUE);
+	G_entry.getStat(G_llHdl, M199_SDRAM_VERIFY, 0, (INT32_OR_64*)&mode);
+	vs.errCount = 1;
+	OpStart();
+	err = SetBlk(M199_BLK_SDRAM, &acc, blkSize);
+	if( !err )
+		err = GetBlk(M199_BLK_VERIFY_STAT, &vs, sizeof(vs));
+	OpEnd("sdram verified setstat", err, mode == TRUE && vs.errCount == 0);
+
+	G_entry.setStat(G_llHdl, M199_SDRAM_POS, 0, FC_OFFS);
+	vs.errCount = 1;
+	OpStart();
+	err = G_entry.blockWrite(G_llHdl, 0, acc.buf, acc.size, &nbr);
+	if( !err )
+		err = GetBlk(M199_BLK_VERIFY_STAT, &vs, sizeof(vs));
+	OpEnd("verified block write", err, vs.errCount == 0);
+
+	G_entry.setStat(G_llHdl, M199_SDRAM_VERIFY, 0, FALSE);
+}
+
+/********************************* TestAsync ********************************/
+/** Asynchronous SDRAM transfers
+ */
+static void TestAsync(void)
+{
+	static u_int8 reqBuf[M199_ASYNC_REQ_MINSIZE + AS_SIZE];
+	static u_int8 doneBuf[M199_ASYNC_DONE_MINSIZE + AS_SIZE];
+	M199_ASYNC_REQ *req = (M199_ASYNC_REQ*)reqBuf;
+	M199_ASYNC_DONE *done = (M199_ASYNC_DONE*)doneBuf;
+	u_int16 *data;
+	u_int32 n, k, okAll = TRUE;
+	int32 err = 0;
+
+	/* queue the writes and the reads, all in flight at once */
+	OpStart();
+	for (k = 0; k < 2 * AS_NUM && !err; k++){
+		req->tag    = k;
+		req->flags  = k < AS_NUM ? M199_ASYNC_WRITE : 0;
+		req->offset = FC_OFFS + (k % AS_NUM) * AS_SIZE;
+		req->size   = AS_SIZE;
+		data = req->buf;
+		for (n = 0; n < AS_SIZE / 2; n++)
+			data[n] = (u_int16)(n * 0x0101 + k);
+		err = SetBlk(M199_BLK_ASYNC_SUBMIT, req, sizeof(reqBuf));
+	}
+	OpEnd("async submit", err, TRUE);
+
+	/* the last read by tag, the rest oldest first */
+	OpStart();
+	for (k = 0; k < 2 * AS_NUM && !err; k++){
+		done->tag     = (k == 0) ? 2 * AS_NUM - 1 : M199_ASYNC_ANY;
+		done->timeout = 1000;
+		err = GetBlk(M199_BLK_ASYNC_WAIT, done, sizeof(doneBuf));
+		if( err || done->error ){
+			okAll = FALSE;
+			break;
+		}
+		if( k == 0 ? done->tag != 2 * AS_NUM - 1 : done->tag != k - 1 )
+			okAll = FALSE;
+		if( done->flags & M199_ASYNC_WRITE )
+			continue;
+		data = done->buf;
+		for (n = 0; n < AS_SIZE / 2; n++)
+			if( data[n] != (u_int16)(n * 0x0101 + done->tag - AS_NUM) )
+				okAll = FALSE;
+	}
+	OpEnd("async wait", err, okAll);
+
+	/* nothing left */
+	done->tag     = M199_ASYNC_ANY;
+	done->timeout = 0;
+	OpStart();
+	err = GetBlk(M199_BLK_ASYNC_WAIT, done, sizeof(doneBuf));
+	OpEnd("async wait empty", 0, err == ERR_LL_ILL_PARAM);
+}
+
+/******************************* TestAsyncChunk *****************************/
+/** Asynchronous transfers of several worker chunks, verify error
+ */
+static void TestAsyncChunk(void)
+{
+	static u_int8 reqBuf[M199_ASYNC_REQ_MINSIZE + AS_BIG];
+	static u_int8 doneBuf[M199_ASYNC_DONE_MINSIZE + AS_BIG];
+	M199_ASYNC_REQ *req = (M199_ASYNC_REQ*)reqBuf;
+	M199_ASYNC_DONE *done = (M199_ASYNC_DONE*)doneBuf, *big;
+	M199_VERIFY_STAT vs;
+	u_int32 n, ok;
+	int32 err;
+
+	/* verified write with a stuck bit, verify is taken at submit */
+	G_sim->sdramStuckOffs = AS_STUCK;
+	G_sim->sdramStuckMask = 0x01;
+	G_entry.setStat(G_llHdl, M199_SDRAM_VERIFY, 0, TRUE);
+	req->tag    = 0x100;
+	req->flags  = M199_ASYNC_WRITE;
+	req->offset = FC_OFFS;
+	req->size   = AS_BIG;
+	memset(req->buf, 0xff, AS_BIG);
+	OpStart();
+	err = SetBlk(M199_BLK_ASYNC_SUBMIT, req, sizeof(reqBuf));
+	G_entry.setStat(G_llHdl, M199_SDRAM_VERIFY, 0, FALSE);
+	done->tag     = 0x100;
+	done->timeout = 1000;
+	if( !err )
+		err = GetBlk(M199_BLK_ASYNC_WAIT, done, sizeof(doneBuf));
+	if( !err )
+		err = GetBlk(M199_BLK_VERIFY_STAT, &vs, sizeof(vs));
+	OpEnd("async verify error", err, done->error == ERR_LL_WRITE &&
+		  vs.errCount == 1 && vs.errOffset == (AS_STUCK & ~1));
+	G_sim->sdramStuckMask = 0;
+
+	/* read back */
+	req->tag   = 0x101;
+	req->flags = 0;
+	OpStart();
+	err = SetBlk(M199_BLK_ASYNC_SUBMIT, req, M199_ASYNC_REQ_MINSIZE);
+	done->tag = 0x101;
+	if( !err )
+		err = GetBlk(M199_BLK_ASYNC_WAIT, done, sizeof(doneBuf));
+	ok = (done->error == 0);
+	for (n = 0; n < AS_BIG / 2; n++)
+		if( (done->buf[n] == 0xffff) == (n == (AS_STUCK - FC_OFFS) / 2) )
+			ok = FALSE;
+	OpEnd("async chunked read", err, ok);
+
+	/* the worker transfers several chunks per run */
+	big = (M199_ASYNC_DONE*)malloc(M199_ASYNC_DONE_MINSIZE + AS_HUGE);
+	if( big == NULL ){
+		OpEnd("async alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		return;
+	}
+	req->tag    = 0x102;
+	req->offset = 0;
+	req->size   = AS_HUGE;
+	OpStart();
+	err = SetBlk(M199_BLK_ASYNC_SUBMIT, req, M199_ASYNC_REQ_MINSIZE);
+	big->tag     = 0x102;
+	big->timeout = 1000;
+	if( !err )
+		err = GetBlk(M199_BLK_ASYNC_WAIT, big,
+					 M199_ASYNC_DONE_MINSIZE + AS_HUGE);
+	OpEnd("async large read", err, big->error == 0 && big->size == AS_HUGE);
+	free(big);
+}
+
+/******************************* TestAsyncQueue *****************************/
+/** Full asynchronous request queue
+ */
+static void TestAsyncQueue(void)
+{
+	M199_ASYNC_REQ req;
+	M199_ASYNC_DONE done;
+	u_int32 k, num = 0, first = 0;
+	int32 err = 0;
+
+	req.flags  = 0;
+	req.offset = FC_OFFS;
+	req.size   = 2;
+	done.timeout = 1000;
+
+	/* all in progress: rejected */
+	OpStart();
+	for (k = 0; k < M199_ASYNC_MAX && !err; k++){
+		req.tag = k;
+		err = SetBlk(M199_BLK_ASYNC_SUBMIT, &req, sizeof(req));
+	}
+	if( !err ){
+		req.tag = k;
+		err = SetBlk(M199_BLK_ASYNC_SUBMIT, &req, sizeof(req));
+		err = (err == ERR_LL_DEV_BUSY) ? 0 : -1;
+	}
+	OpEnd("async queue full", err, TRUE);
+
+	/* completed but not waited for: the oldest is dropped when full */
+	done.tag = M199_ASYNC_MAX - 1;
+	OpStart();
+	err = GetBlk(M199_BLK_ASYNC_WAIT, &done, sizeof(done));
+	for (k = M199_ASYNC_MAX; k < M199_ASYNC_MAX + 2 && !err; k++){
+		req.tag = k;
+		err = SetBlk(M199_BLK_ASYNC_SUBMIT, &req, sizeof(req));
+	}
+	done.tag = 0;
+	OpEnd("async queue drop", err,
+		  GetBlk(M199_BLK_ASYNC_WAIT, &done, sizeof(done)) == ERR_LL_ILL_PARAM);
+
+	OpStart();
+	for (;;){
+		done.tag = M199_ASYNC_ANY;
+		if( GetBlk(M199_BLK_ASYNC_WAIT, &done, sizeof(done)) )
+			break;
+		if( num++ == 0 )
+			first = done.tag;
+	}
+	/* tags 1..M199_ASYNC_MAX-2 and the two new ones */
+	OpEnd("async queue reap", 0, num == M199_ASYNC_MAX && first == 1);
+}
+
+/******************************** TestCmdList *******************************/
+/** Command list
+ */
+static void TestCmdList(void)
+{
+	static u_int8 listBuf[M199_CMD_LIST_HDRSIZE(9) + 2 * 0x100];
+	static const M199_CMD cmds[] = {
+		{ M199_CMD_LED,			0,			0x55,		0 },
+		{ M199_CMD_SDRAM_WR,	FC_OFFS,	0x100,		0 },
+		{ M199_CMD_DELAY,		0,			10,			0 },
+		{ M199_CMD_SDRAM_RD,	FC_OFFS,	0x100,		0 },
+		{ M199_CMD_IRQ_ENABLE,	0,			0,			0 },
+		/* user module, not decoded in A24 */
+		{ M199_CMD_WR16,		0x10,		0x1234,		0 },
+		{ M199_CMD_WR32,		0x20,		0x89abcdef,	0 },
+		{ M199_CMD_RD16,		0x10,		0,			0 },
+		{ M199_CMD_RD32,		0x20,		0,			0 },
+	};
+	M199_CMD_LIST *list = (M199_CMD_LIST*)listBuf, *wrap;
+	u_int16 *data;
+	u_int32 n, num = sizeof(cmds) / sizeof(M199_CMD);
+	int32 err, led = 0, ok;
+
+#ifdef M199_A24
+	num -= 4;
+#endif
+	list->cmdNum = num;
+	memcpy(list->cmd, cmds, num * sizeof(M199_CMD));
+	data = M199_CMD_LIST_DATA(list);
+	for (n = 0; n < 0x80; n++)
+		data[n] = (u_int16)(n * 0x0307);
+
+	OpStart();
+	err = GetBlk(M199_BLK_CMD_LIST, list, M199_CMD_LIST_HDRSIZE(num) + 0x200);
+	OpEnd("command list", err, TRUE);
+
+	G_entry.getStat(G_llHdl, M199_LED, 0, (INT32_OR_64*)&led);
+	ok = (list->done == num && led == 0x55);
+	for (n = 0; n < 0x80; n++)
+		if( data[0x80 + n] != data[n] )
+			ok = FALSE;
+#ifndef M199_A24
+	if( list->cmd[7].value != 0x1234 || list->cmd[8].value != 0x89abcdef )
+		ok = FALSE;
+#endif
+	OpStart();
+	OpEnd("command list result", 0, ok);
+
+	/* rejected before anything is executed */
+	list->cmdNum = 2;
+	list->cmd[0] = cmds[0];
+	list->cmd[0].value = 0x2a;
+	list->cmd[1] = cmds[1];
+	list->cmd[1].offset = CH_SIZE;
+	OpStart();
+	err = GetBlk(M199_BLK_CMD_LIST, list, sizeof(listBuf));
+	G_entry.getStat(G_llHdl, M199_LED, 0, (INT32_OR_64*)&led);
+	OpEnd("command list illegal", 0, err == ERR_LL_ILL_PARAM && led == 0x55);
+
+	list->cmd[1] = cmds[2];
+	list->cmd[1].value = M199_CMD_DELAY_MAX + 1;
+	OpStart();
+	err = GetBlk(M199_BLK_CMD_LIST, list, sizeof(listBuf));
+	G_entry.getStat(G_llHdl, M199_LED, 0, (INT32_OR_64*)&led);
+	OpEnd("command list long delay", 0, err == ERR_LL_ILL_PARAM && led == 0x55);
+
+	/* SDRAM sizes summing up to 4GB (wraps to 0) without any data */
+	wrap = (M199_CMD_LIST*)malloc(M199_CMD_LIST_HDRSIZE(SG_WRAP_NUM));
+	if( !wrap ){
+		OpEnd("command list alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		return;
+	}
+	wrap->cmdNum = SG_WRAP_NUM;
+	for (n = 0; n < SG_WRAP_NUM; n++){
+		wrap->cmd[n].op     = M199_CMD_SDRAM_RD;
+		wrap->cmd[n].offset = 0;
+		wrap->cmd[n].value  = CH_SIZE;
+	}
+	OpStart();
+	err = GetBlk(M199_BLK_CMD_LIST, wrap, M199_CMD_LIST_HDRSIZE(SG_WRAP_NUM));
+	OpEnd("command list size wrap", 0, err == ERR_LL_USERBUF);
+	free(wrap);
+}
+
+/******************************** TestUserReg *******************************/
+/** User module registers
+ */
+static void TestUserReg(void)
+{
+	static u_int8 wrBuf[M199_USER_REG_MINSIZE + 8 * sizeof(u_int32)];
+	static u_int8 rdBuf[M199_USER_REG_MINSIZE + 8 * sizeof(u_int32)];
+	M199_USER_REG *wr = (M199_USER_REG*)wrBuf;
+	M199_USER_REG *rd = (M199_USER_REG*)rdBuf;
+	u_int32 n, width;
+	int32 err, ok;
+
+	for (width = 2; width <= 4; width += 2){
+		wr->offset = rd->offset = 0x20 * width;
+		wr->num    = rd->num    = 8;
+		wr->width  = rd->width  = width;
+		for (n = 0; n < 8; n++)
+			wr->val[n] = (width == 2) ? 0x1111 * n : 0x01020304 * n + 0x8000;
+
+		OpStart();
+		err = SetBlk(M199_BLK_USER_REG, wr, sizeof(wrBuf));
+		if( !err )
+			err = GetBlk(M199_BLK_USER_REG, rd, sizeof(rdBuf));
+#ifdef M199_A24
+		/* no user module registers in A24 */
+		ok  = (err == ERR_LL_ILL_PARAM);
+		err = 0;
+#else
+		ok = !memcmp(wr->val, rd->val, 8 * sizeof(u_int32));
+#endif
+		OpEnd(width == 2 ? "user regs D16" : "user regs D32", err, ok);
+	}
+
+	/* beyond the user module */
+	rd->offset = M199_USER_SIZE - 2;
+	rd->num    = 1;
+	rd->width  = 4;
+	OpStart();
+	err = GetBlk(M199_BLK_USER_REG, rd, sizeof(rdBuf));
+	OpEnd("user regs illegal", 0, err == ERR_LL_ILL_PARAM);
+}
+
+/******************************** TestRegWait *******************************/
+/** Wait for register value
+ */
+static void TestRegWait(void)
+{
+	M199_USER_REG wr;
+	M199_REG_WAIT rw;
+	int32 err, ok;
+
+	wr.offset = 0x30;
+	wr.num    = 1;
+	wr.width  = 2;
+	wr.val[0] = 0x125a;
+	SetBlk(M199_BLK_USER_REG, &wr, sizeof(wr));
+
+	/* condition met */
+	memset(&rw, 0, sizeof(rw));
+	rw.offset   = 0x30;
+	rw.width    = 2;
+	rw.mask     = 0xff;
+	rw.value    = 0x5a;
+	rw.timeout  = 100;
+	OpStart();
+	err = GetBlk(M199_BLK_REG_WAIT, &rw, sizeof(rw));
+#ifdef M199_A24
+	/* no user module registers in A24 */
+	ok  = (err == ERR_LL_ILL_PARAM);
+	err = 0;
+#else
+	ok = (rw.regVal == 0x125a && rw.polls == 1);
+#endif
+	OpEnd("reg wait", err, ok);
+
+	/* timeout, busy and sleeping */
+	rw.value    = 0xa5;
+	rw.timeout  = 5;
+	rw.interval = 200;
+	OpStart();
+	err = GetBlk(M199_BLK_REG_WAIT, &rw, sizeof(rw));
+#ifdef M199_A24
+	ok  = (err == ERR_LL_ILL_PARAM);
+	err = 0;
+#else
+	ok = (rw.regVal == 0x125a && rw.polls > 1 && rw.elapsed >= 5);
+#endif
+	OpEnd("reg wait timeout", err, ok);
+
+	rw.flags    = M199_REG_WAIT_SLEEP;
+	rw.interval = 1000;
+	OpStart();
+	err = GetBlk(M199_BLK_REG_WAIT, &rw, sizeof(rw));
+#ifdef M199_A24
+	ok  = (err == ERR_LL_ILL_PARAM);
+	err = 0;
+#else
+	ok = (rw.polls > 1 && rw.elapsed >= 5);
+#endif
+	OpEnd("reg wait sleep timeout", err, ok);
+
+	/* busy endless wait is rejected */
+	rw.flags   = 0;
+	rw.timeout = -1;
+	OpStart();
+	err = GetBlk(M199_BLK_REG_WAIT, &rw, sizeof(rw));
+	OpEnd("reg wait illegal", 0, err == ERR_LL_ILL_PARAM);
+
+	/* long busy wait is rejected */
+	rw.timeout = M199_REG_WAIT_BUSY_MAX + 1;
+	OpStart();
+	err = GetBlk(M199_BLK_REG_WAIT, &rw, sizeof(rw));
+	OpEnd("reg wait busy limit", 0, err == ERR_LL_ILL_PARAM);
+
+	/* long sleeping wait, condition met */
+	rw.value   = 0x5a;
+	rw.timeout = 0x7fffffff;
+	rw.flags   = M199_REG_WAIT_SLEEP;
+	OpStart();
+	err = GetBlk(M199_BLK_REG_WAIT, &rw, sizeof(rw));
+#ifdef M199_A24
+	ok  = (err == ERR_LL_ILL_PARAM);
+	err = 0;
+#else
+	ok = (rw.regVal == 0x125a && rw.polls == 1 && rw.elapsed == 0);
+#endif
+	OpEnd("reg wait long sleep", err, ok);
+}
+
+/******************************* TestReadWrite ******************************/
+/** M_read/M_write of the channel user registers
+ */
+static void TestReadWrite(void)
+{
+#ifndef M199_A24
+	M199_USER_REG rd;
+#endif
+	int32 err, val = 0;
+
+	OpStart();
+	err = G_entry.write(G_llHdl, 0, 0x13572468);
+	if( !err )
+		err = G_entry.read(G_llHdl, 0, &val);
+#ifdef M199_A24
+	/* no user module registers in A24 */
+	OpEnd("read/write", 0, err == ERR_LL_ILL_CHAN);
+#else
+	OpEnd("read/write", err, val == 0x13572468);
+
+	rd.offset = 0x60;
+	rd.num    = 1;
+	rd.width  = 4;
+	err = GetBlk(M199_BLK_USER_REG, &rd, sizeof(rd));
+	OpStart();
+	OpEnd("read/write register", err, rd.val[0] == 0x13572468);
+#endif
+
+	OpStart();
+	err = G_entry.read(G_llHdl, 1, &val);
+	OpEnd("read no register", 0, err == ERR_LL_ILL_CHAN);
+}
+
+/********************************** TestUsm *********************************/
+/** USM EEPROM
+ */
+static void TestUsm(void)
+{
+	u_int16 ref[M199_USM_SIZE], buf[M199_USM_SIZE];
+	u_int32 n;
+	int32 err;
+
+	for (n = 0; n < M199_USM_SIZE; n++)
+		ref[n] = (u_int16)(0x1000 + n);
+
+	OpStart();
+	err = SetBlk(M199_BLK_USM_MODULE, ref, sizeof(ref));
+	OpEnd("usm write", err, !memcmp(G_sim->usm, ref, sizeof(ref)));
+
+	memset(buf, 0, sizeof(buf));
+	OpStart();
+	err = GetBlk(M199_BLK_USM_MODULE, buf, sizeof(buf));
+	OpEnd("usm read", err, !memcmp(buf, ref, sizeof(ref)));
+}
+
+/********************************* TestFlash ********************************/
+/** Flash programming and readback
+ */
+static void TestFlash(void)
+{
+	M199_FLASH_PROG *fp;
+	M199_FLASH_ACCESS *fa;
+	M199_FLASH_STAT stat;
+	u_int32 n, size = 2 * FLASH_SECT;
+	u_int32 fpSize = M199_FLASH_PROG_MINSIZE + size;
+	u_int32 faSize = M199_FLASH_ACCESS_MINSIZE + size;
+	int32 err;
+
+	fp = (M199_FLASH_PROG*)malloc(fpSize);
+	fa = (M199_FLASH_ACCESS*)malloc(faSize);
+	if( !fp || !fa ){
+		OpEnd("flash alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		goto cleanup;
+	}
+	fp->offset = 0;
+	fp->size   = size;
+	fp->flags  = M199_FLASH_PROG_FIRST;
+	for (n = 0; n < size / 2; n++)
+		fp->buf[n] = (u_int16)(n ^ 0xa5c3);
+
+	OpStart();
+	err = SetBlk(M199_BLK_FLASH_PROG, fp, fpSize);
+	GetBlk(M199_BLK_FLASH_STAT, &stat, sizeof(stat));
+	OpEnd("flash prog (2 sect)", err, stat.sectProgrammed == 2);
+
+	OpStart();
+	err = SetBlk(M199_BLK_FLASH_PROG, fp, fpSize);
+	GetBlk(M199_BLK_FLASH_STAT, &stat, sizeof(stat));
+	OpEnd("flash prog (unchanged)", err, stat.sectSkipped == 2);
+
+	fa->offset = 0;
+	fa->size   = size;
+	fa->flags  = 0;
+	OpStart();
+	err = GetBlk(M199_BLK_FLASH, fa, faSize);
+	OpEnd("flash read", err, !memcmp(fa->buf, fp->buf, size));
+
+cleanup:
+	free(fp);
+	free(fa);
+}
+
+/********************************** TestIrq *********************************/
+/** Interrupt handling
+ */
+static void TestIrq(void)
+{
+	u_int32 count[M199_IRQ_SRC_NUM];
+	int32 err;
+
+	G_entry.setStat(G_llHdl, M_MK_IRQ_ENABLE, 0, 1);
+	OpStart();
+	err = M199_SimIrqRaise(G_sim, 0x08) ? G_entry.irq(G_llHdl) : -1;
+	OpEnd("irq", err == LL_IRQ_DEVICE ? 0 : ERR_LL_READ, G_sim->irr == 0);
+
+	GetBlk(M199_BLK_IRQ_COUNT, count, sizeof(count));
+	OpStart();
+	OpEnd("irq count", 0, count[3] == 1);
+	G_entry.setStat(G_llHdl, M_MK_IRQ_ENABLE, 0, 0);
+}
+
+/********************************* TestStats ********************************/
+/** Driver statistics: the driver counts must match the model
+ *  (the address registers are written as two D16 cycles)
+ *
+ *  \param size       \IN  transfer size [bytes]
+ */
+static void TestStats(u_int32 size)
+{
+	M199_SIM_CYCLES cyc;
+	M199_STATS st;
+	u_int16 *buf;
+	int32 err, nbr;
+
+	if( (buf = (u_int16*)malloc(size)) == NULL ){
+		OpEnd("stats alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		return;
+	}
+	G_entry.setStat(G_llHdl, M199_STATS_RESET, 0, 0);
+	G_entry.setStat(G_llHdl, M199_SDRAM_POS, 0, SDRAM_OFFS);
+
+	OpStart();
+	err = G_entry.blockRead(G_llHdl, 0, buf, size, &nbr);
+	M199_SimCycles(G_sim, &cyc, FALSE);
+	if( !err )
+		err = GetBlk(M199_BLK_STATS, &st, sizeof(st));
+	OpEnd("stats (block read)", err,
+		  st.d16Rd == cyc.d16Rd && st.d16Wr == cyc.d16Wr &&
+		  st.d32Rd == cyc.d32Rd && st.d32Wr == cyc.d32Wr &&
+		  st.sdramAddrSet * 2 == cyc.sdramAddrWr &&
+		  st.sdramRd == size && st.blkRdCalls == 1 &&
+		  st.setCalls[M199_STAT_SLOT(M199_SDRAM_POS)] == 1 &&
+		  st.setCalls[M199_STAT_SLOT(M199_STATS_RESET)] == 1);
+	free(buf);
+}
+
+/********************************** TestApi *********************************/
+/** M199 client library: chunked and in-place transfers, buffer pool
+ */
+static void TestApi(void)
+{
+	M199API_HANDLE *h = NULL;
+	M199_SDRAM_ACCESS acc;
+	u_int16 *ref, *buf, *p = NULL, *q = NULL;
+	u_int32 n, size = 0, size2;
+	int32 err, ok;
+
+	ref = (u_int16*)malloc(API_SIZE);
+	buf = (u_int16*)malloc(API_SIZE);
+	if( !ref || !buf ){
+		OpEnd("api alloc", ERR_OSS_MEM_ALLOC, FALSE);
+		goto cleanup;
+	}
+	for (n = 0; n < API_SIZE / 2; n++)
+		ref[n] = (u_int16)(n * 0x0301 + 0x1c);
+
+	/* smallest transfer buffers, several chunks per transfer */
+	OpStart();
+	err = M199API_Open("m199_sim", M199API_BUF_MIN, 2, &h);
+	OpEnd("api open", err, h != NULL);
+	if( err )
+		goto cleanup;
+
+	OpStart();
+	err = M199API_SdramWrite(h, FC_OFFS, ref, API_SIZE);
+	acc.offset = FC_OFFS + API_SIZE - 2;
+	acc.size   = 2;
+	if( !err )
+		err = GetBlk(M199_BLK_SDRAM, &acc, M199_SDRAM_ACCESS_MINSIZE + 2);
+	OpEnd("api chunked write", err, acc.buf[0] == ref[API_SIZE / 2 - 1]);
+
+	memset(buf, 0, API_SIZE);
+	OpStart();
+	err = M199API_SdramRead(h, FC_OFFS, buf, API_SIZE);
+	OpEnd("api chunked read", err, !memcmp(buf, ref, API_SIZE));
+
+	/* pool buffers are transferred in place, also with no free buffer */
+	p = M199API_BufGet(h, &size);
+	q = M199API_BufGet(h, &size2);
+	OpStart();
+	ok = (p && q && size == M199API_BUF_MIN &&
+		  ((U_INT32_OR_64)p % M199API_BUF_ALIGN) == 0);
+	err = ok ? 0 : ERR_LL_ILL_PARAM;
+	if( !err ){
+		memcpy(p, ref, size);
+		err = M199API_SdramWrite(h, FC_OFFS + API_SIZE, p, size);
+	}
+	if( !err ){
+		memset(p, 0, size);
+		err = M199API_SdramRead(h, FC_OFFS + API_SIZE, p, size);
+	}
+	OpEnd("api in place", err, ok && !memcmp(p, ref, size));
+
+	/* other transfers need a free buffer */
+	OpStart();
+	err = M199API_SdramRead(h, FC_OFFS, buf, 2);
+	OpEnd("api pool empty", 0,
+		  err == ERR_LL_DEV_BUSY && M199API_BufGet(h, &size2) == NULL);
+
+	M199API_BufPut(h, q);
+	OpStart();
+	err = M199API_SdramRead(h, FC_OFFS, buf, 2);
+	OpEnd("api pool reuse", err, buf[0] == ref[0]);
+	M199API_BufPut(h, p);
+
+	/* device not open */
+	OpStart();
+	OpEnd("api no device", 0,
+		  M199API_SdramRead(NULL, 0, buf, 2) == ERR_LL_ILL_PARAM &&
+		  M199API_LedSet(NULL, 0) == ERR_LL_ILL_PARAM &&
+		  M199API_Path(NULL) == -1);
+
+	OpStart();
+	err = M199API_Close(&h);
+	OpEnd("api close", err, h == NULL);
+
+cleanup:
+	free(ref);
+	free(buf);
+}
+
+/********************************** OpStart *********************************/
+/** Start an operation: reset cycle counters and take start time
+ */
+static void OpStart(void)
+{
+	M199_SimCycles(G_sim, NULL, TRUE);
+	gettimeofday(&G_start, NULL);
+}
+
+/*********************************** OpEnd **********************************/
+/** End an operation and print its cycles
+ *
+ *  \param name       \IN  operation name
+ *  \param err        \IN  driver error code
+ *  \param ok         \IN  data check passed
+ */
+static void OpEnd(const char *name, int32 err, int ok)
+{
+	M199_SIM_CYCLES cyc;
+	struct timeval now;
+	long us;
+
+	gettimeofday(&now, NULL);
+	M199_SimCycles(G_sim, &cyc, FALSE);
+	us = (now.tv_sec - G_start.tv_sec) * 1000000L +
+		(now.tv_usec - G_start.tv_usec);
+
+	printf("%-26s %8lu %8lu %8lu %8lu %6lu %6lu %9ld",
+		   name, (unsigned long)cyc.d16Rd, (unsigned long)cyc.d16Wr,
+		   (unsigned long)cyc.d32Rd, (unsigned long)cyc.d32Wr,
+		   (unsigned long)(cyc.sdramAddrWr + cyc.flashAddrWr),
+		   (unsigned long)(cyc.idRd + cyc.usmRd + cyc.usmWr), us);
+	if( err )
+		printf("  *** error 0x%04lx", (unsigned long)err);
+	else if( !ok )
+		printf("  *** data mismatch");
+	printf("\n");
+
+	if( err || !ok )
+		G_failed++;
+}
+
+/*********************************** GetBlk *********************************/
+/** Block getstat
+ *
+ *  \param code       \IN  getstat code
+ *  \param data       \IN  block data
+ *  \param size       \IN  block size
+ *
+ *  \return	          driver error code
+ */
+static int32 GetBlk(int32 code, void *data, u_int32 size)
+{
+	M_SG_BLOCK blk;
+
+	blk.data = data;
+	blk.size = (int32)size;
+	return( G_entry.getStat(G_llHdl, code, 0, (INT32_OR_64*)&blk) );
+}
+
+/*********************************** SetBlk *********************************/
+/** Block setstat
+ *
+ *  \param code       \IN  setstat code
+ *  \param data       \IN  block data
+ *  \param size       \IN  block size
+ *
+ *  \return	          driver error code
+ */
+static int32 SetBlk(int32 code, void *data, u_int32 size)
+{
+	M_SG_BLOCK blk;
+
+	blk.data = data;
+	blk.size = (int32)size;
+	return( G_entry.setStat(G_llHdl, code, 0, (INT32_OR_64)&blk) );
+}
+
+/********************************** M_open **********************************/
+/** MDIS API replacement for the client library: open the simulated device
+ *
+ *  \param device     \IN  device name (ignored)
+ *
+ *  \return	          API_PATH
+ */
+MDIS_PATH M_open(const char *device)
+{
+	G_apiCh = 0;
+	return(API_PATH);
+}
+
+/********************************** M_close *********************************/
+/** MDIS API replacement: close the simulated device
+ *
+ *  \param path       \IN  path
+ *
+ *  \return	          0
+ */
+int32 M_close(MDIS_PATH path)
+{
+	return(0);
+}
+
+/********************************* M_getstat ********************************/
+/** MDIS API replacement: getstat of the driver
+ *
+ *  \param path       \IN  path
+ *  \param code       \IN  getstat code
+ *  \param dataP      \OUT value or M_SG_BLOCK of a block code
+ *
+ *  \return	          0 or -1 on error (see UOS_ErrnoGet())
+ */
+int32 M_getstat(MDIS_PATH path, int32 code, int32 *dataP)
+{
+	INT32_OR_64 val = 0;
+	int32 err;
+
+	if( code >= M_MK_BLK_OF )
+		err = G_entry.getStat(G_llHdl, code, G_apiCh, (INT32_OR_64*)dataP);
+	else if( (err = G_entry.getStat(G_llHdl, code, G_apiCh, &val)) == 0 )
+		*dataP = (int32)val;
+	G_apiErrno = err;
+	return(err ? -1 : 0);
+}
+
+/********************************* M_setstat ********************************/
+/** MDIS API replacement: setstat of the driver, M_MK_CH_CURRENT
+ *
+ *  \param path       \IN  path
+ *  \param code       \IN  setstat code
+ *  \param data       \IN  value or M_SG_BLOCK of a block code
+ *
+ *  \return	          0 or -1 on error (see UOS_ErrnoGet())
+ */
+int32 M_setstat(MDIS_PATH path, int32 code, INT32_OR_64 data)
+{
+	int32 err = 0;
+
+	if( code == M_MK_CH_CURRENT )
+		G_apiCh = (int32)data;
+	else
+		err = G_entry.setStat(G_llHdl, code, G_apiCh, data);
+	G_apiErrno = err;
+	return(err ? -1 : 0);
+}
+
+/******************************** UOS_ErrnoGet ******************************/
+/** USR_OSS replacement: error of the last M_xxx call
+ *
+ *  \return	          error code
+ */
+int32 UOS_ErrnoGet(void)
+{
+	return(G_apiErrno);
+}
@@ -0,0 +1,57 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ck
+#
+#    Description: Makefile definitions for the M199 register-level simulator
+#                 (driver linked against the register model, user space)
+#
+#-----------------------------------------------------------------------------
+#   Copyright 2007-2019, MEN Mikro Elektronik GmbH
+#*****************************************************************************
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+MAK_NAME=m199_sim
+# the next line is updated during the MDIS installation
+STAMPED_REVISION="_"
+
+DEF_REVISION=MAK_REVISION=$(STAMPED_REVISION)
+MAK_SWITCH=$(SW_PREFIX)$(DEF_REVISION) \
+		$(SW_PREFIX)M199_SIM \
+		$(SW_PREFIX)_LL_DRV_
+
+MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/m199_api$(LIB_SUFFIX)	\
+         $(LIB_PREFIX)$(MEN_LIB_DIR)/usr_utl$(LIB_SUFFIX)	\
+
+MAK_INCL=$(MEN_INC_DIR)/m199_drv.h	\
+         $(MEN_INC_DIR)/m199_sim.h	\
+         $(MEN_INC_DIR)/m199_api.h	\
+         $(MEN_INC_DIR)/men_typs.h	\
+         $(MEN_INC_DIR)/oss.h		\
+         $(MEN_INC_DIR)/desc.h		\
+         $(MEN_INC_DIR)/modcom.h	\
+         $(MEN_INC_DIR)/mdis_api.h	\
+         $(MEN_INC_DIR)/mdis_err.h	\
+         $(MEN_INC_DIR)/ll_defs.h	\
+         $(MEN_INC_DIR)/ll_entry.h	\
+         $(MEN_INC_DIR)/usr_utl.h	\
+
+MAK_INP1=m199_sim_run$(INP_SUFFIX)
+MAK_INP2=m199_sim$(INP_SUFFIX)
+MAK_INP3=m199_sim_env$(INP_SUFFIX)
+MAK_INP4=../../../DRIVER/COM/m199_drv$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1) \
+        $(MAK_INP2) \
+        $(MAK_INP3) \
+        $(MAK_INP4)
@@ -0,0 +1,191 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  m199_api.h
+ *
+ *      \author  ck
+ *
+ *       \brief  User space client library for the M199 driver
+ *
+ *               Wraps the M199 Getstat/Setstat block codes into typed
+ *               calls on a device handle. Transfers of any size are split
+ *               into blocks of the handle's transfer buffer size. The
+ *               transfer buffers are allocated once when the device is
+ *               opened and reused, a transfer does no allocation.
+ *
+ *               An application may get a transfer buffer of the pool
+ *               (M199API_BufGet()) and pass its data area to
+ *               M199API_SdramRead()/M199API_SdramWrite(). The data are then
+ *               transferred in place without copying.
+ *
+ *               A handle must not be used by several threads at the same
+ *               time. For C++ the header provides the RAII classes
+ *               m199::Device and m199::Buffer.
+ *
+ *    \switches  (none)
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2007-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _M199_API_H
+#define _M199_API_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define M199API_BUF_SIZE		0x10000		/**< default transfer buffer size
+												 [bytes] */
+#define M199API_BUF_NUM			2			/**< default number of transfer
+												 buffers */
+#define M199API_BUF_MAX			32			/**< max. number of transfer
+												 buffers */
+#define M199API_BUF_MIN			0x400		/**< min. transfer buffer size
+												 [bytes] */
+#define M199API_BUF_ALIGN		64			/**< alignment of the data area
+												 of a transfer buffer */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** device handle (opaque) */
+typedef struct M199API_HANDLE M199API_HANDLE;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+/* All functions return 0 on success or an MDIS error code,
+ * ERR_LL_ILL_PARAM for a NULL device handle */
+extern int32 M199API_Open(const char *device, u_int32 bufSize, u_int32 bufNum,
+						  M199API_HANDLE **hP);
+extern int32 M199API_Close(M199API_HANDLE **hP);
+extern MDIS_PATH M199API_Path(M199API_HANDLE *h);
+extern int32 M199API_ChannelSet(M199API_HANDLE *h, int32 ch);
+
+extern u_int16 *M199API_BufGet(M199API_HANDLE *h, u_int32 *sizeP);
+extern void M199API_BufPut(M199API_HANDLE *h, u_int16 *data);
+
+extern int32 M199API_SdramRead(M199API_HANDLE *h, u_int32 offset,
+							   u_int16 *buf, u_int32 size);
+extern int32 M199API_SdramWrite(M199API_HANDLE *h, u_int32 offset,
+								const u_int16 *buf, u_int32 size);
+extern int32 M199API_UsmRead(M199API_HANDLE *h, u_int16 *buf);
+extern int32 M199API_UsmWrite(M199API_HANDLE *h, const u_int16 *buf,
+							  int32 update);
+extern int32 M199API_FlashRead(M199API_HANDLE *h, u_int32 offset,
+							   u_int16 *buf, u_int32 size, u_int32 *sumP);
+extern int32 M199API_LedGet(M199API_HANDLE *h, int32 *valueP);
+extern int32 M199API_LedSet(M199API_HANDLE *h, int32 value);
+extern int32 M199API_RegRead(M199API_HANDLE *h, u_int32 offset,
+							 u_int32 width, u_int32 *val, u_int32 num);
+extern int32 M199API_RegWrite(M199API_HANDLE *h, u_int32 offset,
+							  u_int32 width, const u_int32 *val, u_int32 num);
+
+#ifdef __cplusplus
+      }
+
+/*-----------------------------------------+
+|  C++ CLASSES                             |
++-----------------------------------------*/
+namespace m199 {
+
+/** M199 device, open while the object exists
+ *
+ *  The methods return 0 on success or an MDIS error code like the
+ *  M199API_xxx functions. The object can't be copied.
+ */
+class Device {
+public:
+	explicit Device(const char *device, u_int32 bufSize = 0,
+					u_int32 bufNum = 0) : _h(0)
+		{ _err = M199API_Open(device, bufSize, bufNum, &_h); }
+	~Device()
+		{ if( _h ) M199API_Close(&_h); }
+
+	/** error of the open, 0 if the device is open (the methods of a
+	 *  device that is not open fail with ERR_LL_ILL_PARAM) */
+	int32 error() const { return _err; }
+	bool isOpen() const { return _h != 0; }
+	M199API_HANDLE *handle() const { return _h; }
+	MDIS_PATH path() const { return M199API_Path(_h); }
+
+	int32 channel(int32 ch)
+		{ return M199API_ChannelSet(_h, ch); }
+	int32 sdramRead(u_int32 offset, u_int16 *buf, u_int32 size)
+		{ return M199API_SdramRead(_h, offset, buf, size); }
+	int32 sdramWrite(u_int32 offset, const u_int16 *buf, u_int32 size)
+		{ return M199API_SdramWrite(_h, offset, buf, size); }
+	int32 usmRead(u_int16 *buf)
+		{ return M199API_UsmRead(_h, buf); }
+	int32 usmWrite(const u_int16 *buf, bool update = true)
+		{ return M199API_UsmWrite(_h, buf, update ? TRUE : FALSE); }
+	int32 flashRead(u_int32 offset, u_int16 *buf, u_int32 size,
+					u_int32 *sumP = 0)
+		{ return M199API_FlashRead(_h, offset, buf, size, sumP); }
+	int32 ledGet(int32 *valueP)
+		{ return M199API_LedGet(_h, valueP); }
+	int32 ledSet(int32 value)
+		{ return M199API_LedSet(_h, value); }
+	int32 regRead(u_int32 offset, u_int32 width, u_int32 *val,
+				  u_int32 num = 1)
+		{ return M199API_RegRead(_h, offset, width, val, num); }
+	int32 regWrite(u_int32 offset, u_int32 width, const u_int32 *val,
+				   u_int32 num = 1)
+		{ return M199API_RegWrite(_h, offset, width, val, num); }
+
+private:
+	Device(const Device&);
+	Device& operator=(const Device&);
+
+	M199API_HANDLE	*_h;
+	int32			_err;
+};
+
+/** transfer buffer of a device's pool, returned to the pool on destruction
+ *
+ *  data() is NULL if all buffers are in use.
+ */
+class Buffer {
+public:
+	explicit Buffer(Device &dev) : _h(dev.handle()), _size(0), _data(0)
+		{ if( _h ) _data = M199API_BufGet(_h, &_size); }
+	~Buffer()
+		{ if( _data ) M199API_BufPut(_h, _data); }
+
+	u_int16 *data() const { return _data; }
+	/** size of the data area [bytes] */
+	u_int32 size() const { return _size; }
+
+private:
+	Buffer(const Buffer&);
+	Buffer& operator=(const Buffer&);
+
+	M199API_HANDLE	*_h;
+	u_int32			_size;
+	u_int16			*_data;
+};
+
+} /* namespace m199 */
+
+#endif /* __cplusplus */
+
+#endif /* _M199_API_H */
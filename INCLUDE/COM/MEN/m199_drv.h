@@ -46,6 +46,17 @@
  */
 /**@{*/
 #define M199_LED			 (M_DEV_OF+0x00)		/**< G,S: LED signal 			*/
+#define M199_SDRAM_POS		 (M_DEV_OF+0x01)		/**< G,S: SDRAM block i/o pos	*/
+#define M199_IRQ_MASK		 (M_DEV_OF+0x02)		/**< G,S: Enabled irq sources	*/
+#define M199_SIG_SET		 (M_DEV_OF+0x03)		/**<  S:  Install irq signal	*/
+#define M199_SIG_CLR		 (M_DEV_OF+0x04)		/**<  S:  Remove irq signal		*/
+#define M199_IRQ_CLR		 (M_DEV_OF+0x05)		/**<  S:  Clear irq events/count*/
+#define M199_USM_WR_COUNT	 (M_DEV_OF+0x06)		/**<  G:  USM words last written*/
+#define M199_USM_CACHE		 (M_DEV_OF+0x07)		/**< G,S: USM EEPROM shadow		*/
+#define M199_STATS_RESET	 (M_DEV_OF+0x08)		/**<  S:  Reset statistics		*/
+#define M199_SDRAM_VERIFY	 (M_DEV_OF+0x09)		/**< G,S: Verify SDRAM writes	*/
+#define M199_ASYNC_SIG_SET	 (M_DEV_OF+0x0a)		/**<  S:  Install async signal	*/
+#define M199_ASYNC_SIG_CLR	 (M_DEV_OF+0x0b)		/**<  S:  Remove async signal	*/
 /**@}*/
 
 /** \name M199 specific Getstat/Setstat block codes */
@@ -53,16 +64,80 @@
 #define M199_BLK_SDRAM       (M_DEV_BLK_OF+0x00) 	/**< G,S: SDRAM read/write 		*/
 #define M199_BLK_USM_MODULE  (M_DEV_BLK_OF+0x01) 	/**< G,S: USM EEPROM read/write */
 #define M199_BLK_FPGA_HEADER (M_DEV_BLK_OF+0x02)	/**<  G:  Read Fpga_header 	  	*/
+#define M199_BLK_SDRAM_SG    (M_DEV_BLK_OF+0x03)	/**< G,S: SDRAM segments r/w	*/
+#define M199_BLK_SDRAM_MAP   (M_DEV_BLK_OF+0x04)	/**<  G:  SDRAM window (A24)	*/
+#define M199_BLK_IRQ_WAIT    (M_DEV_BLK_OF+0x05)	/**<  G:  Wait for irq event	*/
+#define M199_BLK_IRQ_COUNT   (M_DEV_BLK_OF+0x06)	/**<  G:  Irq count per source	*/
+#define M199_BLK_USM_UPDATE  (M_DEV_BLK_OF+0x07)	/**<  S:  Write changed USM words*/
+#define M199_BLK_USM_PART    (M_DEV_BLK_OF+0x08)	/**<  G:  Read USM EEPROM words */
+#define M199_BLK_FPGA_INFO   (M_DEV_BLK_OF+0x09)	/**<  G:  Decoded Fpga_header	*/
+#define M199_BLK_FLASH       (M_DEV_BLK_OF+0x0a)	/**<  G:  Flash read/checksum	*/
+#define M199_BLK_FLASH_PROG  (M_DEV_BLK_OF+0x0b)	/**<  S:  Program flash sectors	*/
+#define M199_BLK_FLASH_STAT  (M_DEV_BLK_OF+0x0c)	/**<  G:  Flash program progress*/
+#define M199_BLK_STATS       (M_DEV_BLK_OF+0x0d)	/**<  G:  Driver statistics		*/
+#define M199_BLK_SDRAM_TEST  (M_DEV_BLK_OF+0x0e)	/**<  G:  SDRAM memory test		*/
+#define M199_BLK_SDRAM_FILL  (M_DEV_BLK_OF+0x0f)	/**<  S:  Fill SDRAM area		*/
+#define M199_BLK_SDRAM_COPY  (M_DEV_BLK_OF+0x10)	/**<  S:  Copy SDRAM area		*/
+#define M199_BLK_SDRAM_CHECK (M_DEV_BLK_OF+0x11)	/**<  G:  SDRAM checksum/min/max*/
+#define M199_BLK_SDRAM_FIND  (M_DEV_BLK_OF+0x12)	/**<  G:  Search SDRAM value	*/
+#define M199_BLK_VERIFY_STAT (M_DEV_BLK_OF+0x13)	/**<  G:  Last write verification*/
+#define M199_BLK_ASYNC_SUBMIT (M_DEV_BLK_OF+0x14)	/**<  S:  Queue SDRAM transfer	*/
+#define M199_BLK_ASYNC_WAIT  (M_DEV_BLK_OF+0x15)	/**<  G:  Wait for SDRAM transfer*/
+#define M199_BLK_CMD_LIST    (M_DEV_BLK_OF+0x16)	/**<  G:  Execute command list	*/
+#define M199_BLK_USER_REG    (M_DEV_BLK_OF+0x17)	/**< G,S: User module registers	*/
+#define M199_BLK_REG_WAIT    (M_DEV_BLK_OF+0x18)	/**<  G:  Wait for register value*/
 /**@}*/
 
 #define M199_SDRAM_BUFFER_SIZE	512		/**< Buffersize for SDRAM data in words */
+#define M199_SDRAM_SIZE		0x1000000	/**< Size of the SDRAM in bytes */
+#define M199_IRQ_SRC_NUM		32			/**< Number of interrupt sources */
+#define M199_CH_MAX				16			/**< Max. number of SDRAM channels */
+#define M199_ASYNC_MAX			32			/**< Max. queued async transfers
+												 incl. completed ones */
+#define M199_USM_SIZE			128			/**< USM EEPROM size in words */
+#ifdef M199_A24
+# define M199_USER_SIZE			0x00		/**< User module register space
+												 [bytes], overlaid by the
+												 SDRAM window in A24 */
+#else
+# define M199_USER_SIZE			0xD0		/**< User module register space
+												 [bytes] */
+#endif
+#define M199_FPGA_HEADER_SIZE	128			/**< FPGA header size in words */
+#define M199_FPGA_NAME_LEN		28			/**< FPGA header file name length */
+#define M199_FPGA_FIELD_NUM		56			/**< FPGA header fields after name */
+
+#define M199_STAT_STD_NUM		16			/**< statistics: standard code slots */
+#define M199_STAT_BLK_NUM		32			/**< statistics: block code slots */
+#define M199_STAT_CODE_NUM		(M199_STAT_STD_NUM + M199_STAT_BLK_NUM + 1)
+											/**< statistics: slots incl. other */
+/** statistics slot of a status code: M_DEV_OF+n -> n,
+ *  M_DEV_BLK_OF+n -> M199_STAT_STD_NUM+n, others -> last slot */
+#define M199_STAT_SLOT(code) \
+	((u_int32)((code) - M_DEV_OF) < M199_STAT_STD_NUM ? \
+	 (u_int32)((code) - M_DEV_OF) : \
+	 (u_int32)((code) - M_DEV_BLK_OF) < M199_STAT_BLK_NUM ? \
+	 M199_STAT_STD_NUM + (u_int32)((code) - M_DEV_BLK_OF) : \
+	 M199_STAT_CODE_NUM - 1)
+
+/*-----------------------------------------+
+|  BACKWARD COMPATIBILITY TO MDIS4         |
++-----------------------------------------*/
+#ifndef U_INT32_OR_64
+ /* we have an MDIS4 men_types.h and mdis_api.h included */
+ /* only 32bit compatibility needed!                     */
+ #define INT32_OR_64  int32
+ #define U_INT32_OR_64 u_int32
+ typedef INT32_OR_64  MDIS_PATH;
+#endif /* U_INT32_OR_64 */
 
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
 /** blk structure to be sent to setstat / getstat */
 typedef struct {
-	u_int32  offset;					/**< offset of the sdram base */
+	u_int32  offset;					/**< offset in the channel's SDRAM
+											 area */
 	u_int32  size;						/**< size in byte */
 	u_int16 buf[M199_SDRAM_BUFFER_SIZE];/**< buffer for the data */
 }M199_SDRAM_ACCESS;
@@ -70,6 +145,406 @@ typedef struct {
 #define M199_SDRAM_ACCESS_MINSIZE	\
 	(sizeof(M199_SDRAM_ACCESS) - (sizeof(u_int16) * M199_SDRAM_BUFFER_SIZE))
 
+/** SDRAM segment of M199_SDRAM_SG */
+typedef struct {
+	u_int32  offset;					/**< offset in the channel's SDRAM
+											 area */
+	u_int32  size;						/**< size in byte */
+}M199_SDRAM_SEG;
+
+/** blk structure for M199_BLK_SDRAM_SG
+ *
+ *  The segment list is followed by the data of all segments in the order
+ *  of the list (see M199_SDRAM_SG_DATA). The block size must be at least
+ *  M199_SDRAM_SG_HDRSIZE(segNum) plus the sum of all segment sizes.
+ */
+typedef struct {
+	u_int32  segNum;					/**< number of segments */
+	M199_SDRAM_SEG seg[1];				/**< segment list (segNum entries) */
+}M199_SDRAM_SG;
+
+/** size of a M199_SDRAM_SG structure with \a n segments */
+#define M199_SDRAM_SG_HDRSIZE(n)	\
+	(sizeof(u_int32) + ((n) * sizeof(M199_SDRAM_SEG)))
+
+/** pointer to the data of a M199_SDRAM_SG structure */
+#define M199_SDRAM_SG_DATA(sgP)	\
+	((u_int16*)((u_int8*)(sgP) + M199_SDRAM_SG_HDRSIZE((sgP)->segNum)))
+
+/** blk structure returned by M199_BLK_SDRAM_MAP */
+typedef struct {
+	u_int32  physAddr;					/**< physical address of the window
+											 (descriptor key SDRAM_PHYS_ADDR
+											 + offset) */
+	u_int32  offset;					/**< offset of the window in the
+										 	 module address space */
+	u_int32  size;						/**< size of the window in byte */
+}M199_SDRAM_MAP;
+
+/** blk structure for M199_BLK_USM_PART */
+typedef struct {
+	u_int16  offset;					/**< first word to read */
+	u_int16  count;						/**< number of words to read */
+	u_int16  buf[M199_USM_SIZE];		/**< buffer for the data */
+}M199_USM_PART;
+
+#define M199_USM_PART_MINSIZE	\
+	(sizeof(M199_USM_PART) - (sizeof(u_int16) * M199_USM_SIZE))
+
+/** blk structure returned by M199_BLK_FPGA_INFO
+ *
+ *  The header is a byte stream with the most significant byte first.
+ *  It starts with a 32-bit magic word and the file name of the FPGA
+ *  configuration, the remaining header is returned as 32-bit fields.
+ */
+typedef struct {
+	u_int32  magic;						/**< header bytes 0..3 */
+	char     fileName[M199_FPGA_NAME_LEN+1];	/**< header bytes 4..31,
+										 	 zero terminated */
+	u_int32  field[M199_FPGA_FIELD_NUM];/**< header bytes 32..255 */
+}M199_FPGA_INFO;
+
+/** blk structure for M199_BLK_FLASH
+ *
+ *  The block may be of any size. Without M199_FLASH_SUM_ONLY it must hold
+ *  M199_FLASH_ACCESS_MINSIZE + size bytes, the data are returned in buf[].
+ */
+typedef struct {
+	u_int32  offset;					/**< in: flash offset [bytes] */
+	u_int32  size;						/**< in: size [bytes] */
+	u_int32  flags;						/**< in: M199_FLASH_xxx flags */
+	u_int32  sum;						/**< out: 32-bit sum of all words */
+	u_int16  buf[1];					/**< out: data (size/2 words) */
+}M199_FLASH_ACCESS;
+
+#define M199_FLASH_SUM_ONLY		0x01	/**< return checksum only, no data */
+
+#define M199_FLASH_ACCESS_MINSIZE	\
+	(sizeof(M199_FLASH_ACCESS) - sizeof(u_int16))
+
+/** blk structure for M199_BLK_FLASH_PROG
+ *
+ *  offset must be aligned to the flash sector size (descriptor key
+ *  FLASH_SECT_SIZE). A sector that is only partly covered by the data is
+ *  left erased (0xffff) behind the data.
+ */
+typedef struct {
+	u_int32  offset;					/**< flash offset [bytes] */
+	u_int32  size;						/**< size [bytes] */
+	u_int32  flags;						/**< M199_FLASH_PROG_xxx flags */
+	u_int16  buf[1];					/**< data (size/2 words) */
+}M199_FLASH_PROG;
+
+#define M199_FLASH_PROG_FIRST	0x01	/**< first block of an update:
+											 reset progress counters */
+#define M199_FLASH_PROG_FORCE	0x02	/**< program unchanged sectors too */
+
+#define M199_FLASH_PROG_MINSIZE	\
+	(sizeof(M199_FLASH_PROG) - sizeof(u_int16))
+
+/** blk structure returned by M199_BLK_FLASH_STAT */
+typedef struct {
+	u_int32  sectDone;					/**< sectors processed */
+	u_int32  sectSkipped;				/**< sectors skipped (unchanged) */
+	u_int32  sectProgrammed;			/**< sectors erased and programmed */
+	u_int32  bytesDone;					/**< bytes processed */
+	u_int32  errOffset;					/**< offset of the last error */
+	u_int32  errStatus;					/**< flash status of last error */
+}M199_FLASH_STAT;
+
+/** blk structure returned by M199_BLK_STATS,
+ *  all counters wrap around at 2^32. They are not locked and therefore
+ *  approximate while the device is used concurrently. */
+typedef struct {
+	u_int32  tickRate;					/**< OSS ticks per second */
+	u_int32  d16Rd;						/**< D16 read cycles */
+	u_int32  d16Wr;						/**< D16 write cycles */
+	u_int32  d32Rd;						/**< D32 read cycles */
+	u_int32  d32Wr;						/**< D32 write cycles */
+	u_int32  sdramAddrSet;				/**< SDRAM address register writes */
+	u_int32  flashAddrSet;				/**< flash address register writes */
+	u_int32  sdramRd;					/**< SDRAM bytes read */
+	u_int32  sdramWr;					/**< SDRAM bytes written */
+	u_int32  flashRd;					/**< flash bytes read */
+	u_int32  flashWr;					/**< flash bytes programmed */
+	u_int32  usmRd;						/**< USM EEPROM bytes read from
+											 the module */
+	u_int32  usmWr;						/**< USM EEPROM bytes written */
+	u_int32  blkRdCalls;				/**< M_getblock calls */
+	u_int32  blkRdTicks;				/**< ticks spent in M_getblock */
+	u_int32  blkWrCalls;				/**< M_setblock calls */
+	u_int32  blkWrTicks;				/**< ticks spent in M_setblock */
+	u_int32  setCalls[M199_STAT_CODE_NUM];	/**< setstat calls per slot */
+	u_int32  setTicks[M199_STAT_CODE_NUM];	/**< setstat ticks per slot */
+	u_int32  getCalls[M199_STAT_CODE_NUM];	/**< getstat calls per slot */
+	u_int32  getTicks[M199_STAT_CODE_NUM];	/**< getstat ticks per slot */
+}M199_STATS;
+
+/** SDRAM memory test failure */
+typedef struct {
+	u_int32  offset;					/**< offset in the channel's SDRAM
+											 area */
+	u_int16  expect;					/**< written word */
+	u_int16  actual;					/**< read word */
+	u_int32  test;						/**< failed test (M199_SDRAM_TEST_xxx) */
+}M199_SDRAM_ERR;
+
+#define M199_SDRAM_ERR_NUM		8		/**< failures reported in detail */
+
+/** blk structure for M199_BLK_SDRAM_TEST
+ *
+ *  The tests overwrite the SDRAM range.
+ */
+typedef struct {
+	u_int32  offset;					/**< in: offset in the channel's
+											 SDRAM area [bytes] */
+	u_int32  size;						/**< in: size [bytes] */
+	u_int32  tests;						/**< in: M199_SDRAM_TEST_xxx flags */
+	u_int32  seed;						/**< in: M199_SDRAM_TEST_RANDOM seed */
+	u_int32  maxErr;					/**< in: stop after maxErr failures
+											 (0=test the whole range) */
+	u_int32  errCount;					/**< out: number of failed words */
+	u_int32  errTests;					/**< out: failed tests */
+	u_int32  ticks;						/**< out: test time [OSS ticks] */
+	u_int32  tickRate;					/**< out: OSS ticks per second */
+	M199_SDRAM_ERR err[M199_SDRAM_ERR_NUM]; /**< out: first failures */
+}M199_SDRAM_TEST;
+
+/** \name M199_SDRAM_TEST tests */
+/**@{*/
+#define M199_SDRAM_TEST_WALK1	0x01	/**< walking ones (data lines) */
+#define M199_SDRAM_TEST_WALK0	0x02	/**< walking zeros (data lines) */
+#define M199_SDRAM_TEST_ADDR	0x04	/**< address-in-address (address
+											 lines) */
+#define M199_SDRAM_TEST_CHECKER	0x08	/**< checkerboard and inverse */
+#define M199_SDRAM_TEST_RANDOM	0x10	/**< pseudo-random data */
+#define M199_SDRAM_TEST_ALL		0x1f	/**< all tests */
+/**@}*/
+
+/** blk structure for M199_BLK_SDRAM_FILL */
+typedef struct {
+	u_int32  offset;					/**< offset in the channel's SDRAM
+											 area [bytes] */
+	u_int32  size;						/**< size [bytes] */
+	u_int32  pattern;					/**< fill pattern */
+	u_int32  width;						/**< pattern width: 2 (u_int16) or
+											 4 (u_int32 as read into a
+											 u_int32 buffer) */
+}M199_SDRAM_FILL;
+
+/** blk structure for M199_BLK_SDRAM_COPY, the areas may overlap */
+typedef struct {
+	u_int32  srcOffset;					/**< source offset in the channel's
+											 SDRAM area [bytes] */
+	u_int32  dstOffset;					/**< destination offset in the
+											 channel's SDRAM area [bytes] */
+	u_int32  size;						/**< size [bytes] */
+}M199_SDRAM_COPY;
+
+/** blk structure for M199_BLK_SDRAM_CHECK
+ *
+ *  The words are the 16-bit samples as returned by M199_BLK_SDRAM. The
+ *  CRC is the CRC-32 (IEEE 802.3) of these data in memory, i.e. the value
+ *  of a crc32() over the M199_BLK_SDRAM buffer.
+ */
+typedef struct {
+	u_int32  offset;					/**< in: offset in the channel's
+											 SDRAM area [bytes] */
+	u_int32  size;						/**< in: size [bytes] */
+	u_int32  flags;						/**< in: M199_SDRAM_CHECK_xxx */
+	u_int32  crc;						/**< out: CRC-32 (with
+											 M199_SDRAM_CHECK_CRC) */
+	u_int32  sumLo;						/**< out: sum of all words, bits
+											 0..31 (additive checksum) */
+	u_int32  sumHi;						/**< out: sum, bits 32..63 */
+	int32    min;						/**< out: smallest word */
+	int32    max;						/**< out: largest word */
+}M199_SDRAM_CHECK;
+
+#define M199_SDRAM_CHECK_CRC	0x01	/**< compute the CRC-32 */
+#define M199_SDRAM_CHECK_SIGNED	0x02	/**< min/max/sum of int16 samples */
+
+/** blk structure for M199_BLK_SDRAM_FIND
+ *
+ *  Searches the first word with (word & mask) == (value & mask).
+ */
+typedef struct {
+	u_int32  offset;					/**< in: offset in the channel's
+											 SDRAM area [bytes] */
+	u_int32  size;						/**< in: size [bytes] */
+	u_int16  value;						/**< in: value to search */
+	u_int16  mask;						/**< in: compared bits */
+	u_int32  found;						/**< out: TRUE if found */
+	u_int32  foundOffset;				/**< out: offset of the first match
+											 in the channel's SDRAM area */
+}M199_SDRAM_FIND;
+
+/** blk structure returned by M199_BLK_VERIFY_STAT, result of the last
+ *  verified SDRAM write of the channel (see M199_SDRAM_VERIFY) */
+typedef struct {
+	u_int32  errCount;					/**< number of mismatching words */
+	u_int32  errOffset;					/**< offset of the first mismatch in
+											 the channel's SDRAM area */
+}M199_VERIFY_STAT;
+
+/** blk structure for M199_BLK_ASYNC_SUBMIT
+ *
+ *  A write request must hold M199_ASYNC_REQ_MINSIZE + size bytes, the
+ *  data are copied into the driver.
+ */
+typedef struct {
+	u_int32  tag;						/**< caller's request tag */
+	u_int32  flags;						/**< M199_ASYNC_xxx flags */
+	u_int32  offset;					/**< offset in the channel's SDRAM
+											 area [bytes] */
+	u_int32  size;						/**< size [bytes] */
+	u_int16  buf[1];					/**< write data (size/2 words) */
+}M199_ASYNC_REQ;
+
+#define M199_ASYNC_WRITE		0x01	/**< write request (default read) */
+
+#define M199_ASYNC_REQ_MINSIZE	\
+	(sizeof(M199_ASYNC_REQ) - sizeof(u_int16))
+
+/** blk structure for M199_BLK_ASYNC_WAIT
+ *
+ *  For a read request the block must hold M199_ASYNC_DONE_MINSIZE + size
+ *  bytes, the data are returned in buf[].
+ */
+typedef struct {
+	u_int32  tag;						/**< in: tag of the request or
+											 M199_ASYNC_ANY (oldest request
+											 of the channel)
+											 out: tag of the request */
+	int32    timeout;					/**< in: max. wait time [ms]
+										 	 (0=no wait, -1=endless) */
+	int32    error;						/**< out: transfer result,
+											 ERR_LL_WRITE if a verified
+											 write mismatched */
+	u_int32  flags;						/**< out: M199_ASYNC_xxx flags */
+	u_int32  offset;					/**< out: offset [bytes] */
+	u_int32  size;						/**< out: size [bytes] */
+	u_int16  buf[1];					/**< out: read data (size/2 words) */
+}M199_ASYNC_DONE;
+
+#define M199_ASYNC_ANY			0xffffffff	/**< wait for any request */
+
+#define M199_ASYNC_DONE_MINSIZE	\
+	(sizeof(M199_ASYNC_DONE) - sizeof(u_int16))
+
+/** blk structure for M199_BLK_USER_REG
+ *
+ *  Reads or writes \a num consecutive registers of the user module. The
+ *  block must hold M199_USER_REG_MINSIZE + num * sizeof(u_int32) bytes.
+ */
+typedef struct {
+	u_int32  offset;					/**< offset of the first register
+											 [bytes] */
+	u_int32  num;						/**< number of registers */
+	u_int32  width;						/**< register width: 2 (D16) or
+											 4 (D32) [bytes] */
+	u_int32  val[1];					/**< register values (num entries) */
+}M199_USER_REG;
+
+#define M199_USER_REG_MINSIZE	\
+	(sizeof(M199_USER_REG) - sizeof(u_int32))
+
+/** blk structure for M199_BLK_REG_WAIT
+ *
+ *  Polls a user module register until (register & mask) == value or the
+ *  timeout expires. The call also succeeds on a timeout, the condition is
+ *  then not met by regVal.
+ */
+typedef struct {
+	u_int32  offset;					/**< in: register offset [bytes] */
+	u_int32  width;						/**< in: register width: 2 (D16)
+											 or 4 (D32) [bytes] */
+	u_int32  mask;						/**< in: mask of the compared bits */
+	u_int32  value;						/**< in: expected value */
+	int32    timeout;					/**< in: max. wait time [ms]
+										 	 (0=check once, -1=endless,
+										 	 M199_REG_WAIT_SLEEP only) */
+	u_int32  interval;					/**< in: poll interval [us]
+											 (0=continuous) */
+	u_int32  flags;						/**< in: M199_REG_WAIT_xxx flags */
+	u_int32  regVal;					/**< out: last register value */
+	u_int32  elapsed;					/**< out: wait time [ms] */
+	u_int32  polls;						/**< out: number of register reads */
+}M199_REG_WAIT;
+
+#define M199_REG_WAIT_SLEEP		0x01	/**< sleep between the polls (the
+											 interval is rounded up to
+											 ms), default: busy delay */
+
+#define M199_REG_WAIT_BUSY_MAX	100		/**< max. timeout [ms] of a busy
+											 wait (without M199_REG_WAIT_SLEEP),
+											 the max. interval is the same
+											 time in us (100000 us) */
+
+/** command of M199_CMD_LIST */
+typedef struct {
+	u_int32  op;						/**< M199_CMD_xxx operation */
+	u_int32  offset;					/**< user module register offset or
+											 offset in the channel's SDRAM
+											 area [bytes] */
+	u_int32  value;						/**< in: write value, LED value,
+											 irq enable, delay [us] or
+											 SDRAM size [bytes]
+											 out: read value */
+	int32    error;						/**< out: result of the command */
+}M199_CMD;
+
+#define M199_CMD_RD16			1		/**< read D16 register */
+#define M199_CMD_WR16			2		/**< write D16 register */
+#define M199_CMD_RD32			3		/**< read D32 register */
+#define M199_CMD_WR32			4		/**< write D32 register */
+#define M199_CMD_LED			5		/**< set LEDs (see M199_LED) */
+#define M199_CMD_SDRAM_WR		6		/**< write SDRAM data */
+#define M199_CMD_SDRAM_RD		7		/**< read SDRAM data */
+#define M199_CMD_IRQ_ENABLE		8		/**< enable/disable interrupts
+											 (see M_MK_IRQ_ENABLE) */
+#define M199_CMD_DELAY			9		/**< delay [us] */
+
+#define M199_CMD_DELAY_MAX		10000	/**< max. delay of M199_CMD_DELAY
+											 [us] */
+
+/** blk structure for M199_BLK_CMD_LIST
+ *
+ *  The command list is followed by the data of all SDRAM commands in the
+ *  order of the list (see M199_CMD_LIST_DATA). The block size must be at
+ *  least M199_CMD_LIST_HDRSIZE(cmdNum) plus the sum of all SDRAM sizes.
+ */
+typedef struct {
+	u_int32  cmdNum;					/**< number of commands */
+	u_int32  done;						/**< out: number of successfully
+											 executed commands */
+	M199_CMD cmd[1];					/**< command list (cmdNum entries) */
+}M199_CMD_LIST;
+
+/** size of a M199_CMD_LIST structure with \a n commands */
+#define M199_CMD_LIST_HDRSIZE(n)	\
+	(2 * sizeof(u_int32) + ((n) * sizeof(M199_CMD)))
+
+/** pointer to the SDRAM data of a M199_CMD_LIST structure */
+#define M199_CMD_LIST_DATA(listP)	\
+	((u_int16*)((u_int8*)(listP) + M199_CMD_LIST_HDRSIZE((listP)->cmdNum)))
+
+/** interrupt event */
+typedef struct {
+	u_int32  irr;						/**< interrupt sources (IRR & IER) */
+	u_int32  tick;						/**< OSS tick count at interrupt */
+}M199_IRQ_EVENT;
+
+/** blk structure for M199_BLK_IRQ_WAIT */
+typedef struct {
+	int32    timeout;					/**< in: max. wait time [ms]
+										 	 (0=no wait, -1=endless) */
+	u_int32  lost;						/**< out: events lost since last
+										 	 call (queue overflow) */
+	u_int32  tickRate;					/**< out: OSS ticks per second */
+	M199_IRQ_EVENT ev;					/**< out: oldest queued event */
+}M199_IRQ_WAIT;
+
 
 /*-----------------------------------------+
 |  PROTOTYPES                              |
@@ -96,17 +571,6 @@ extern void M199_GetEntry(LL_ENTRY* drvP);
 
 #endif /* _LL_DRV_ */
 
-/*-----------------------------------------+
-|  BACKWARD COMPATIBILITY TO MDIS4         |
-+-----------------------------------------*/
-#ifndef U_INT32_OR_64
- /* we have an MDIS4 men_types.h and mdis_api.h included */
- /* only 32bit compatibility needed!                     */
- #define INT32_OR_64  int32
- #define U_INT32_OR_64 u_int32
- typedef INT32_OR_64  MDIS_PATH;
-#endif /* U_INT32_OR_64 */
-
 #ifdef __cplusplus
       }
 #endif
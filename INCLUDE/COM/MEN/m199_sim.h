@@ -0,0 +1,134 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  m199_sim.h
+ *
+ *      \author  ck
+ *
+ *       \brief  Register-level simulator of the M199 M-Module
+ *
+ *               Replaces maccess.h when the driver is compiled with
+ *               M199_SIM. The MACCESS handle then points to an M199_SIM_HW
+ *               structure and all D16/D32 accesses of the driver are
+ *               routed to the register model, which counts the bus cycles.
+ *
+ *    \switches  M199_SIM, M199_A24, MAC_BYTESWAP
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2007-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _M199_SIM_H
+#define _M199_SIM_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define M199_SIM_SDRAM_SIZE		0x1000000	/**< SDRAM size [bytes] */
+#define M199_SIM_REG_SIZE		0x100		/**< A08 register space [bytes] */
+#define M199_SIM_REG_A24		0xD0		/**< first register decoded in
+												 the A24 window */
+#define M199_SIM_FLASH_SIZE		0x1000000	/**< default flash size [bytes] */
+#define M199_SIM_FLASH_SECT		0x20000		/**< default sector size [bytes] */
+#define M199_SIM_ID_SIZE		64			/**< ID PROM size [words] */
+#define M199_SIM_USM_SIZE		128			/**< USM EEPROM size [words] */
+#define M199_SIM_PHYS_ADDR		0xE0000000	/**< physical address of the
+												 A24 window */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** bus cycle counters */
+typedef struct {
+	u_int32	d16Rd;						/**< D16 read cycles */
+	u_int32	d16Wr;						/**< D16 write cycles */
+	u_int32	d32Rd;						/**< D32 read cycles */
+	u_int32	d32Wr;						/**< D32 write cycles */
+	u_int32	sdramAddrWr;				/**< SDRAM address register writes */
+	u_int32	flashAddrWr;				/**< flash address register writes */
+	u_int32	idRd;						/**< ID PROM word reads */
+	u_int32	usmRd;						/**< USM EEPROM word reads */
+	u_int32	usmWr;						/**< USM EEPROM word writes */
+}M199_SIM_CYCLES;
+
+/** simulated M199 module, MACCESS points to this structure */
+typedef struct {
+	u_int16	reg[M199_SIM_REG_SIZE/2];	/**< register file (bus order) */
+	u_int8	*sdram;						/**< SDRAM (bus order) */
+	u_int32	sdramAddr;					/**< SDRAM port address */
+	u_int32	sdramStuckOffs;				/**< SDRAM byte with stuck bits */
+	u_int8	sdramStuckMask;				/**< bits of this byte stuck at 0
+											 (0=none) */
+	u_int8	*flash;						/**< flash image */
+	u_int32	flashSize;					/**< flash size [bytes] */
+	u_int32	flashSect;					/**< flash sector size [bytes] */
+	u_int32	flashAddr;					/**< flash address */
+	u_int32	flashMode;					/**< flash state machine */
+	u_int16	flashStatus;				/**< flash status register */
+	u_int32	flashBusy;					/**< status reads until ready */
+	u_int32	flashBusyReads;				/**< busy reads per operation */
+	u_int32	irr;						/**< interrupt request register */
+	u_int16	id[M199_SIM_ID_SIZE];		/**< ID PROM */
+	u_int16	usm[M199_SIM_USM_SIZE];		/**< USM EEPROM */
+	M199_SIM_CYCLES cyc;				/**< bus cycle counters */
+}M199_SIM_HW;
+
+/** descriptor key for the simulated DESC library, list ends with NULL key */
+typedef struct {
+	char	*key;						/**< key name */
+	u_int32	val;						/**< key value */
+}M199_SIM_DESC;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern M199_SIM_HW *M199_SimCreate(u_int32 flashSize, u_int32 flashSect);
+extern void M199_SimDestroy(M199_SIM_HW *sim);
+extern void M199_SimCycles(M199_SIM_HW *sim, M199_SIM_CYCLES *cycP, int32 reset);
+extern int32 M199_SimIrqRaise(M199_SIM_HW *sim, u_int32 mask);
+extern u_int8 *M199_SimMap(M199_SIM_HW *sim, u_int32 physAddr, u_int32 size);
+
+extern u_int16 M199_SimRead16(void *ma, u_int32 offs);
+extern void M199_SimWrite16(void *ma, u_int32 offs, u_int16 val);
+extern u_int32 M199_SimRead32(void *ma, u_int32 offs);
+extern void M199_SimWrite32(void *ma, u_int32 offs, u_int32 val);
+
+/*-----------------------------------------+
+|  ACCESS MACROS (maccess.h replacement)   |
++-----------------------------------------*/
+#ifdef M199_SIM
+
+typedef void *MACCESS;					/**< points to M199_SIM_HW */
+
+/* the access functions swap the bus values with MAC_BYTESWAP */
+# define MREAD_D16(ma,offs)			M199_SimRead16((ma),(offs))
+# define MWRITE_D16(ma,offs,val)	M199_SimWrite16((ma),(offs),(u_int16)(val))
+# define MREAD_D32(ma,offs)			M199_SimRead32((ma),(offs))
+# define MWRITE_D32(ma,offs,val)	M199_SimWrite32((ma),(offs),(u_int32)(val))
+
+#endif /* M199_SIM */
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _M199_SIM_H */
@@ -0,0 +1,615 @@
+/*********************  P r o g r a m  -  M o d u l e *************************/
+/*!
+ *        \file  m199_api.c
+ *
+ *      \author  ck
+ *
+ *      \brief   User space client library for the M199 driver
+ *
+ *               See m199_api.h. Each transfer buffer of a handle holds a
+ *               header area of BUF_HDR_SIZE bytes in front of its data
+ *               area. The block structure of a transfer is placed so that
+ *               its data field starts at the data area, so the data area
+ *               stays aligned for all block codes.
+ *
+ *     Required: libraries: mdis_api, usr_oss
+ *     \switches (none)
+ *
+ *
+ *---------------------------------------------------------------------------
+ * Copyright 2007-2019, MEN Mikro Elektronik GmbH
+ ****************************************************************************/
+
+ /*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <MEN/men_typs.h>
+#include <MEN/usr_oss.h>
+#include <MEN/mdis_api.h>
+#include <MEN/mdis_err.h>
+#include <MEN/m199_drv.h>
+#include <MEN/m199_api.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define BUF_HDR_SIZE		M199API_BUF_ALIGN	/**< header area of a transfer
+													 buffer, holds the largest
+													 block header */
+
+/** block header in front of the data area \a d of a transfer buffer */
+#define BUF_BLK(d,minsize)	((void*)((u_int8*)(d) - (minsize)))
+
+/*--------------------------------------+
+|   TYPDEFS                             |
++--------------------------------------*/
+/** device handle */
+struct M199API_HANDLE {
+	MDIS_PATH	path;						/**< MDIS path */
+	u_int32		bufSize;					/**< data area size [bytes] */
+	u_int32		bufNum;						/**< number of buffers */
+	u_int32		bufUsed;					/**< buffers in use (bit mask) */
+	u_int8		*mem;						/**< allocated buffer memory */
+	u_int16		*buf[M199API_BUF_MAX];		/**< data areas */
+};
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int32 BufFind(M199API_HANDLE *h, const void *data);
+static int32 SdramXfer(M199API_HANDLE *h, u_int32 offset, u_int16 *buf,
+					   u_int32 size, int32 write);
+
+/******************************** M199API_Open ********************************/
+/** Open a device and allocate its transfer buffers
+ *
+ *  \param device     \IN  Device name
+ *  \param bufSize    \IN  Transfer buffer size [bytes] (0=M199API_BUF_SIZE),
+ *                         at least M199API_BUF_MIN, a multiple of
+ *                         M199API_BUF_ALIGN
+ *  \param bufNum     \IN  Number of transfer buffers (0=M199API_BUF_NUM)
+ *  \param hP         \OUT Device handle
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_Open(
+	const char		*device,
+	u_int32			bufSize,
+	u_int32			bufNum,
+	M199API_HANDLE	**hP
+)
+{
+	M199API_HANDLE *h;
+	U_INT32_OR_64 addr;
+	u_int32 n;
+	int32 error;
+
+	*hP = NULL;
+	if( bufSize == 0 )
+		bufSize = M199API_BUF_SIZE;
+	if( bufNum == 0 )
+		bufNum = M199API_BUF_NUM;
+	if( bufSize < M199API_BUF_MIN || (bufSize % M199API_BUF_ALIGN) ||
+		bufNum > M199API_BUF_MAX )
+		return(ERR_LL_ILL_PARAM);
+
+	if( (h = (M199API_HANDLE*)calloc(1, sizeof(M199API_HANDLE))) == NULL )
+		return(ERR_OSS_MEM_ALLOC);
+	h->bufSize = bufSize;
+	h->bufNum  = bufNum;
+
+	/* buffers: header area and data area, data aligned */
+	h->mem = (u_int8*)malloc(bufNum * (BUF_HDR_SIZE + bufSize) +
+							 M199API_BUF_ALIGN);
+	if( h->mem == NULL ){
+		free(h);
+		return(ERR_OSS_MEM_ALLOC);
+	}
+	addr = ((U_INT32_OR_64)h->mem + M199API_BUF_ALIGN - 1) &
+		~(U_INT32_OR_64)(M199API_BUF_ALIGN - 1);
+	for (n=0; n < bufNum; n++)
+		h->buf[n] = (u_int16*)(addr + n * (BUF_HDR_SIZE + bufSize) +
+							   BUF_HDR_SIZE);
+
+	if( (h->path = M_open(device)) < 0 ){
+		error = UOS_ErrnoGet();
+		free(h->mem);
+		free(h);
+		return(error);
+	}
+
+	*hP = h;
+	return(ERR_SUCCESS);
+} /* M199API_Open */
+
+/******************************* M199API_Close ********************************/
+/** Close a device and free its transfer buffers
+ *
+ *  \param hP         \IN  Device handle
+ *                    \OUT NULL
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_Close(
+	M199API_HANDLE	**hP
+)
+{
+	M199API_HANDLE *h = *hP;
+	int32 error = ERR_SUCCESS;
+
+	if( h == NULL )
+		return(ERR_SUCCESS);
+	if( M_close(h->path) < 0 )
+		error = UOS_ErrnoGet();
+	free(h->mem);
+	free(h);
+	*hP = NULL;
+
+	return(error);
+} /* M199API_Close */
+
+/******************************** M199API_Path ********************************/
+/** MDIS path of a device, e.g. for codes without library function
+ *
+ *  \param h          \IN  Device handle
+ *
+ *  \return           MDIS path or -1 if no device is open
+ ******************************************************************************/
+MDIS_PATH M199API_Path(
+	M199API_HANDLE	*h
+)
+{
+	if( h == NULL )
+		return(-1);
+	return(h->path);
+} /* M199API_Path */
+
+/***************************** M199API_ChannelSet *****************************/
+/** Select the SDRAM channel of the path
+ *
+ *  \param h          \IN  Device handle
+ *  \param ch         \IN  Channel
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_ChannelSet(
+	M199API_HANDLE	*h,
+	int32			ch
+)
+{
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	if( M_setstat(h->path, M_MK_CH_CURRENT, ch) < 0 )
+		return(UOS_ErrnoGet());
+	return(ERR_SUCCESS);
+} /* M199API_ChannelSet */
+
+/******************************* M199API_BufGet *******************************/
+/** Get a transfer buffer of the pool
+ *
+ *  Data in the buffer are transferred in place by M199API_SdramRead() and
+ *  M199API_SdramWrite() if the transfer starts at the buffer's data area.
+ *
+ *  \param h          \IN  Device handle
+ *  \param sizeP      \OUT Size of the data area [bytes]
+ *
+ *  \return           Data area or NULL if all buffers are in use
+ ******************************************************************************/
+u_int16 *M199API_BufGet(
+	M199API_HANDLE	*h,
+	u_int32			*sizeP
+)
+{
+	u_int32 n;
+
+	for (n=0; h && n < h->bufNum; n++){
+		if( !(h->bufUsed & ((u_int32)1 << n)) ){
+			h->bufUsed |= (u_int32)1 << n;
+			*sizeP = h->bufSize;
+			return(h->buf[n]);
+		}
+	}
+	*sizeP = 0;
+	return(NULL);
+} /* M199API_BufGet */
+
+/******************************* M199API_BufPut *******************************/
+/** Return a transfer buffer to the pool
+ *
+ *  \param h          \IN  Device handle
+ *  \param data       \IN  Data area from M199API_BufGet()
+ ******************************************************************************/
+void M199API_BufPut(
+	M199API_HANDLE	*h,
+	u_int16			*data
+)
+{
+	int32 n = h ? BufFind(h, data) : -1;
+
+	if( n >= 0 )
+		h->bufUsed &= ~((u_int32)1 << n);
+} /* M199API_BufPut */
+
+/***************************** M199API_SdramRead ******************************/
+/** Read the SDRAM of the current channel
+ *
+ *  \param h          \IN  Device handle
+ *  \param offset     \IN  Offset in the channel's SDRAM area [bytes]
+ *  \param buf        \OUT Data
+ *  \param size       \IN  Size [bytes], any size
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_SdramRead(
+	M199API_HANDLE	*h,
+	u_int32			offset,
+	u_int16			*buf,
+	u_int32			size
+)
+{
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	return( SdramXfer(h, offset, buf, size, FALSE) );
+} /* M199API_SdramRead */
+
+/***************************** M199API_SdramWrite *****************************/
+/** Write the SDRAM of the current channel
+ *
+ *  \param h          \IN  Device handle
+ *  \param offset     \IN  Offset in the channel's SDRAM area [bytes]
+ *  \param buf        \IN  Data
+ *  \param size       \IN  Size [bytes], any size
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_SdramWrite(
+	M199API_HANDLE	*h,
+	u_int32			offset,
+	const u_int16	*buf,
+	u_int32			size
+)
+{
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	return( SdramXfer(h, offset, (u_int16*)buf, size, TRUE) );
+} /* M199API_SdramWrite */
+
+/****************************** M199API_UsmRead *******************************/
+/** Read the USM EEPROM
+ *
+ *  \param h          \IN  Device handle
+ *  \param buf        \OUT M199_USM_SIZE words
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_UsmRead(
+	M199API_HANDLE	*h,
+	u_int16			*buf
+)
+{
+	M_SG_BLOCK blk;
+
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	blk.size = M199_USM_SIZE * 2;
+	blk.data = (void*)buf;
+	if( M_getstat(h->path, M199_BLK_USM_MODULE, (int32*)&blk) < 0 )
+		return(UOS_ErrnoGet());
+	return(ERR_SUCCESS);
+} /* M199API_UsmRead */
+
+/****************************** M199API_UsmWrite ******************************/
+/** Write the USM EEPROM
+ *
+ *  \param h          \IN  Device handle
+ *  \param buf        \IN  M199_USM_SIZE words
+ *  \param update     \IN  TRUE: write changed words only (M199_BLK_USM_UPDATE)
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_UsmWrite(
+	M199API_HANDLE	*h,
+	const u_int16	*buf,
+	int32			update
+)
+{
+	M_SG_BLOCK blk;
+
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	blk.size = M199_USM_SIZE * 2;
+	blk.data = (void*)buf;
+	if( M_setstat(h->path, update ? M199_BLK_USM_UPDATE : M199_BLK_USM_MODULE,
+				  (INT32_OR_64)&blk) < 0 )
+		return(UOS_ErrnoGet());
+	return(ERR_SUCCESS);
+} /* M199API_UsmWrite */
+
+/***************************** M199API_FlashRead ******************************/
+/** Read the flash and/or its checksum
+ *
+ *  \param h          \IN  Device handle
+ *  \param offset     \IN  Flash offset [bytes]
+ *  \param buf        \OUT Data or NULL for the checksum only
+ *  \param size       \IN  Size [bytes], any size
+ *  \param sumP       \OUT 32-bit sum of all words (may be NULL)
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_FlashRead(
+	M199API_HANDLE	*h,
+	u_int32			offset,
+	u_int16			*buf,
+	u_int32			size,
+	u_int32			*sumP
+)
+{
+	M199_FLASH_ACCESS *fa;
+	M_SG_BLOCK blk;
+	u_int16 *data;
+	u_int32 n, chunk, sum = 0, bufSize;
+	int32 error = ERR_SUCCESS;
+
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	if( (data = M199API_BufGet(h, &bufSize)) == NULL )
+		return(ERR_LL_DEV_BUSY);
+	fa = (M199_FLASH_ACCESS*)BUF_BLK(data, M199_FLASH_ACCESS_MINSIZE);
+
+	/* the checksum needs no data transfer, one call */
+	for (n=0; n < size; n += chunk){
+		chunk = (buf == NULL || size - n < bufSize) ? size - n : bufSize;
+		fa->offset = offset + n;
+		fa->size   = chunk;
+		fa->flags  = buf ? 0 : M199_FLASH_SUM_ONLY;
+		blk.size = (int32)(M199_FLASH_ACCESS_MINSIZE + (buf ? chunk : 0));
+		blk.data = (void*)fa;
+		if( M_getstat(h->path, M199_BLK_FLASH, (int32*)&blk) < 0 ){
+			error = UOS_ErrnoGet();
+			break;
+		}
+		sum += fa->sum;
+		if( buf )
+			memcpy((u_int8*)buf + n, fa->buf, chunk);
+	}
+	M199API_BufPut(h, data);
+
+	if( sumP )
+		*sumP = sum;
+	return(error);
+} /* M199API_FlashRead */
+
+/******************************* M199API_LedGet *******************************/
+/** Get the LED state
+ *
+ *  \param h          \IN  Device handle
+ *  \param valueP     \OUT LED bits (see M199_LED)
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_LedGet(
+	M199API_HANDLE	*h,
+	int32			*valueP
+)
+{
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	if( M_getstat(h->path, M199_LED, valueP) < 0 )
+		return(UOS_ErrnoGet());
+	return(ERR_SUCCESS);
+} /* M199API_LedGet */
+
+/******************************* M199API_LedSet *******************************/
+/** Set the LEDs
+ *
+ *  \param h          \IN  Device handle
+ *  \param value      \IN  LED bits (see M199_LED)
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_LedSet(
+	M199API_HANDLE	*h,
+	int32			value
+)
+{
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	if( M_setstat(h->path, M199_LED, value) < 0 )
+		return(UOS_ErrnoGet());
+	return(ERR_SUCCESS);
+} /* M199API_LedSet */
+
+/****************************** M199API_RegRead *******************************/
+/** Read user module registers
+ *
+ *  \param h          \IN  Device handle
+ *  \param offset     \IN  Offset of the first register [bytes]
+ *  \param width      \IN  Register width: 2 (D16) or 4 (D32) [bytes]
+ *  \param val        \OUT Register values
+ *  \param num        \IN  Number of registers
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_RegRead(
+	M199API_HANDLE	*h,
+	u_int32			offset,
+	u_int32			width,
+	u_int32			*val,
+	u_int32			num
+)
+{
+	M199_USER_REG *ur;
+	M_SG_BLOCK blk;
+	u_int32 *data, bufSize;
+	int32 error = ERR_SUCCESS;
+
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	if( (data = (u_int32*)M199API_BufGet(h, &bufSize)) == NULL )
+		return(ERR_LL_DEV_BUSY);
+	if( num > bufSize / sizeof(u_int32) ){
+		M199API_BufPut(h, (u_int16*)data);
+		return(ERR_LL_ILL_PARAM);
+	}
+	ur = (M199_USER_REG*)BUF_BLK(data, M199_USER_REG_MINSIZE);
+	ur->offset = offset;
+	ur->num    = num;
+	ur->width  = width;
+	blk.size = (int32)(M199_USER_REG_MINSIZE + num * sizeof(u_int32));
+	blk.data = (void*)ur;
+	if( M_getstat(h->path, M199_BLK_USER_REG, (int32*)&blk) < 0 )
+		error = UOS_ErrnoGet();
+	else
+		memcpy(val, data, num * sizeof(u_int32));
+	M199API_BufPut(h, (u_int16*)data);
+
+	return(error);
+} /* M199API_RegRead */
+
+/****************************** M199API_RegWrite ******************************/
+/** Write user module registers
+ *
+ *  \param h          \IN  Device handle
+ *  \param offset     \IN  Offset of the first register [bytes]
+ *  \param width      \IN  Register width: 2 (D16) or 4 (D32) [bytes]
+ *  \param val        \IN  Register values
+ *  \param num        \IN  Number of registers
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+int32 M199API_RegWrite(
+	M199API_HANDLE	*h,
+	u_int32			offset,
+	u_int32			width,
+	const u_int32	*val,
+	u_int32			num
+)
+{
+	M199_USER_REG *ur;
+	M_SG_BLOCK blk;
+	u_int32 *data, bufSize;
+	int32 error = ERR_SUCCESS;
+
+	if( h == NULL )
+		return(ERR_LL_ILL_PARAM);
+	if( (data = (u_int32*)M199API_BufGet(h, &bufSize)) == NULL )
+		return(ERR_LL_DEV_BUSY);
+	if( num > bufSize / sizeof(u_int32) ){
+		M199API_BufPut(h, (u_int16*)data);
+		return(ERR_LL_ILL_PARAM);
+	}
+	ur = (M199_USER_REG*)BUF_BLK(data, M199_USER_REG_MINSIZE);
+	ur->offset = offset;
+	ur->num    = num;
+	ur->width  = width;
+	blk.size = (int32)(M199_USER_REG_MINSIZE + num * sizeof(u_int32));
+	blk.data = (void*)ur;
+	memcpy(data, val, num * sizeof(u_int32));
+	if( M_setstat(h->path, M199_BLK_USER_REG, (INT32_OR_64)&blk) < 0 )
+		error = UOS_ErrnoGet();
+	M199API_BufPut(h, (u_int16*)data);
+
+	return(error);
+} /* M199API_RegWrite */
+
+/********************************** BufFind ***********************************/
+/** Find the transfer buffer of a data area
+ *
+ *  \param h          \IN  Device handle
+ *  \param data       \IN  Data pointer
+ *
+ *  \return           Buffer index or -1
+ ******************************************************************************/
+static int32 BufFind(
+	M199API_HANDLE	*h,
+	const void		*data
+)
+{
+	u_int32 n;
+
+	for (n=0; n < h->bufNum; n++)
+		if( (const void*)h->buf[n] == data )
+			return((int32)n);
+	return(-1);
+} /* BufFind */
+
+/********************************* SdramXfer **********************************/
+/** Transfer SDRAM data in blocks of the transfer buffer size
+ *
+ *  Data in a transfer buffer of the handle are transferred in place,
+ *  others are copied through a free transfer buffer.
+ *
+ *  \param h          \IN  Device handle
+ *  \param offset     \IN  Offset in the channel's SDRAM area [bytes]
+ *  \param buf        \IN  Data to write
+ *                    \OUT Read data
+ *  \param size       \IN  Size [bytes]
+ *  \param write      \IN  TRUE: write
+ *
+ *  \return           \c 0 On success or error code
+ ******************************************************************************/
+static int32 SdramXfer(
+	M199API_HANDLE	*h,
+	u_int32			offset,
+	u_int16			*buf,
+	u_int32			size,
+	int32			write
+)
+{
+	M199_SDRAM_ACCESS *acc;
+	M_SG_BLOCK blk;
+	u_int16 *data;
+	u_int32 n, chunk, bufSize;
+	int32 inPlace = (BufFind(h, buf) >= 0);
+	int32 error = ERR_SUCCESS;
+
+	if( inPlace ){
+		if( size > h->bufSize )
+			return(ERR_LL_ILL_PARAM);
+		data = buf;
+	}
+	else if( (data = M199API_BufGet(h, &bufSize)) == NULL )
+		return(ERR_LL_DEV_BUSY);
+	acc = (M199_SDRAM_ACCESS*)BUF_BLK(data, M199_SDRAM_ACCESS_MINSIZE);
+
+	for (n=0; n < size; n += chunk){
+		chunk = (size - n < h->bufSize) ? size - n : h->bufSize;
+		acc->offset = offset + n;
+		acc->size   = chunk;
+		blk.size = (int32)(M199_SDRAM_ACCESS_MINSIZE + chunk);
+		blk.data = (void*)acc;
+
+		if( write ){
+			if( !inPlace )
+				memcpy(data, (u_int8*)buf + n, chunk);
+			if( M_setstat(h->path, M199_BLK_SDRAM, (INT32_OR_64)&blk) < 0 )
+				error = UOS_ErrnoGet();
+		}
+		else {
+			if( M_getstat(h->path, M199_BLK_SDRAM, (int32*)&blk) < 0 )
+				error = UOS_ErrnoGet();
+			else if( !inPlace )
+				memcpy((u_int8*)buf + n, data, chunk);
+		}
+		if( error )
+			break;
+	}
+
+	if( !inPlace )
+		M199API_BufPut(h, data);
+	return(error);
+} /* SdramXfer */